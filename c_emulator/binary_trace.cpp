@@ -0,0 +1,814 @@
+#include "binary_trace.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+// Binary trace file layout. Integers are in host byte order; the header
+// records it so that a trace is not misread on a different host.
+//
+//   magic "SAILTRAC", u32 version, u32 byte order mark
+//   records
+//
+// Every record starts with a RecordHeader and is padded to a multiple of
+// 8 bytes, and its size includes the header itself. String records assign
+// consecutive ids, starting at 0, to names that later records refer to.
+//
+// Records are variable-length rather than fixed-size with a separate string
+// table. The disassembly, vector register values and TLB entries vary in
+// size, and fixed records would have to be as large as the largest of
+// them. The strings are defined in the stream before their first use
+// instead of in a table at the end, so a trace can be decoded as it is
+// read, and a trace cut short (e.g. by a killed simulation) can be
+// decoded up to where it stops.
+
+namespace {
+
+constexpr char trace_magic[8] = {'S', 'A', 'I', 'L', 'T', 'R', 'A', 'C'};
+constexpr uint32_t trace_version = 3;
+constexpr uint32_t trace_byte_order_mark = 0x01020304;
+constexpr size_t record_alignment = 8;
+constexpr uint32_t no_string = UINT32_MAX;
+constexpr size_t max_record_size = size_t{64} << 20;
+
+// How long the writer thread sleeps when there is nothing to write.
+constexpr auto drain_interval = std::chrono::microseconds(200);
+
+enum class RecordKind : uint8_t {
+  // Fills the end of the ring buffer when a record doesn't fit.
+  Pad,
+  String,
+  Text,
+  MemAccess,
+  XregWrite,
+  FregWrite,
+  CsrAccess,
+  VregWrite,
+  PtwStart,
+  PtwStep,
+  PtwSuccess,
+  PtwFail,
+  Tlb,
+  Instr,
+};
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order_mark;
+};
+
+struct RecordHeader {
+  uint32_t size;
+  RecordKind kind;
+  uint8_t reserved[3];
+};
+
+// Followed by `length` characters.
+struct StringRecord {
+  uint32_t id;
+  uint32_t length;
+};
+
+// Followed by `length` characters.
+struct TextRecord {
+  uint64_t length;
+};
+
+// Followed by `value_bytes` bytes of little-endian value.
+struct MemAccessRecord {
+  uint64_t paddr;
+  uint32_t type;
+  uint32_t value_bytes;
+  uint32_t digits;
+  uint8_t paddr_digits;
+  uint8_t is_write;
+  uint8_t reserved[2];
+};
+
+struct XregWriteRecord {
+  uint64_t value;
+  uint64_t reg;
+  uint32_t abi_name;
+  uint32_t digits;
+};
+
+struct FregWriteRecord {
+  uint64_t value;
+  uint32_t reg;
+  uint32_t digits;
+};
+
+struct CsrAccessRecord {
+  uint64_t value;
+  uint32_t csr_name;
+  uint16_t reg;
+  uint8_t is_write;
+  uint8_t digits;
+};
+
+// Followed by `value_bytes` bytes of little-endian value.
+struct VregWriteRecord {
+  uint32_t reg;
+  uint32_t value_bytes;
+  uint32_t digits;
+  uint32_t reserved;
+};
+
+struct PtwStartRecord {
+  uint64_t vpn;
+  uint32_t access_type;
+  uint32_t privilege;
+};
+
+struct PtwStepRecord {
+  int64_t level;
+  uint64_t pte;
+  uint64_t pte_addr;
+};
+
+struct PtwSuccessRecord {
+  uint64_t final_ppn;
+  int64_t level;
+};
+
+struct PtwFailRecord {
+  int64_t level;
+  uint64_t pte_addr;
+  uint32_t error;
+  uint32_t reserved;
+};
+
+// Followed by `num_entries` TlbEntryRecords.
+struct TlbRecord {
+  uint32_t num_entries;
+  uint8_t is_flush;
+  uint8_t reserved[3];
+};
+
+struct TlbEntryRecord {
+  uint64_t index;
+  uint64_t asid;
+  uint64_t vpn;
+  uint64_t pte;
+  uint64_t level_mask;
+  uint64_t ppn;
+  uint64_t pte_addr;
+  uint8_t global;
+  uint8_t reserved[7];
+};
+
+// Followed by `disassembly_length` characters. The privilege and the symbol
+// are names, since they repeat; the disassembly mostly doesn't. `hart` is
+// negative if the trace doesn't show it.
+struct InstrRecord {
+  uint64_t step;
+  uint64_t pc;
+  uint64_t opcode;
+  uint64_t symbol_offset;
+  int64_t hart;
+  uint32_t privilege;
+  uint32_t symbol;
+  uint32_t disassembly_length;
+  uint8_t pc_digits;
+  uint8_t opcode_digits;
+  uint8_t reserved[2];
+};
+
+static_assert(sizeof(RecordHeader) == record_alignment);
+static_assert(sizeof(InstrRecord) % record_alignment == 0);
+static_assert(sizeof(MemAccessRecord) % record_alignment == 0);
+static_assert(sizeof(TlbEntryRecord) % record_alignment == 0);
+
+size_t align_up(size_t size) {
+  return (size + record_alignment - 1) & ~(record_alignment - 1);
+}
+
+bool is_power_of_two(size_t n) {
+  return n != 0 && (n & (n - 1)) == 0;
+}
+
+} // namespace
+
+// The file the writer thread writes to.
+class BinaryTraceOutput {
+public:
+  BinaryTraceOutput(const std::string &filename, bool compress) : m_filename(filename) {
+    if (compress) {
+#ifdef HAVE_ZLIB
+      m_gz = gzopen(filename.c_str(), "wb");
+      if (m_gz == nullptr) {
+        throw std::runtime_error("Cannot create trace file '" + filename + "': " + strerror(errno));
+      }
+      return;
+#else
+      throw std::runtime_error("Trace compression is not supported: the emulator was built without zlib");
+#endif
+    }
+    m_file = fopen(filename.c_str(), "wb");
+    if (m_file == nullptr) {
+      throw std::runtime_error("Cannot create trace file '" + filename + "': " + strerror(errno));
+    }
+  }
+
+  ~BinaryTraceOutput() {
+    close();
+  }
+
+  BinaryTraceOutput(const BinaryTraceOutput &) = delete;
+  BinaryTraceOutput &operator=(const BinaryTraceOutput &) = delete;
+
+  bool write(const void *data, size_t length) {
+#ifdef HAVE_ZLIB
+    if (m_gz != nullptr) {
+      return gzfwrite(data, 1, length, m_gz) == length;
+    }
+#endif
+    return fwrite(data, 1, length, m_file) == length;
+  }
+
+  bool close() {
+    bool ok = true;
+#ifdef HAVE_ZLIB
+    if (m_gz != nullptr) {
+      ok = gzclose(m_gz) == Z_OK;
+      m_gz = nullptr;
+    }
+#endif
+    if (m_file != nullptr) {
+      ok = fclose(m_file) == 0;
+      m_file = nullptr;
+    }
+    return ok;
+  }
+
+  const std::string &filename() const {
+    return m_filename;
+  }
+
+private:
+  std::string m_filename;
+  FILE *m_file = nullptr;
+#ifdef HAVE_ZLIB
+  gzFile m_gz = nullptr;
+#endif
+};
+
+BinaryTraceWriter::BinaryTraceWriter(const std::string &filename, bool compress, size_t buffer_size) :
+    m_output(std::make_unique<BinaryTraceOutput>(filename, compress)) {
+  if (!is_power_of_two(buffer_size) || buffer_size < 4096) {
+    throw std::runtime_error("Trace buffer size must be a power of two of at least 4096 bytes");
+  }
+  m_storage = std::make_unique<uint64_t[]>(buffer_size / sizeof(uint64_t));
+  m_buffer = reinterpret_cast<uint8_t *>(m_storage.get());
+  m_capacity = buffer_size;
+
+  FileHeader header = {};
+  memcpy(header.magic, trace_magic, sizeof(header.magic));
+  header.version = trace_version;
+  header.byte_order_mark = trace_byte_order_mark;
+  if (!m_output->write(&header, sizeof(header))) {
+    throw std::runtime_error("Could not write trace file '" + filename + "': " + strerror(errno));
+  }
+
+  m_thread = std::thread([this] { drain(); });
+}
+
+BinaryTraceWriter::~BinaryTraceWriter() {
+  stop();
+}
+
+void BinaryTraceWriter::close() {
+  stop();
+  const bool closed = m_output->close();
+  if (m_failed.load() || !closed) {
+    throw std::runtime_error("Could not write trace file '" + m_output->filename() + "'");
+  }
+}
+
+void BinaryTraceWriter::stop() {
+  if (m_thread.joinable()) {
+    m_stop.store(true, std::memory_order_release);
+    m_thread.join();
+  }
+}
+
+// The writer thread. Writes whatever has been committed to the ring buffer
+// in as few calls as possible, then releases the space to the producer.
+void BinaryTraceWriter::drain() {
+  uint64_t tail = m_tail.load(std::memory_order_relaxed);
+  for (;;) {
+    // Check for stop before loading the head, so that everything committed
+    // before stop() is still written.
+    const bool stopping = m_stop.load(std::memory_order_acquire);
+    const uint64_t head = m_head.load(std::memory_order_acquire);
+    if (head == tail) {
+      if (stopping) {
+        return;
+      }
+      std::this_thread::sleep_for(drain_interval);
+      continue;
+    }
+    const size_t offset = static_cast<size_t>(tail) & (m_capacity - 1);
+    const size_t length = static_cast<size_t>(std::min<uint64_t>(head - tail, m_capacity - offset));
+    // Keep consuming after an error so that the producer never blocks; the
+    // error is reported by close().
+    if (!m_failed.load(std::memory_order_relaxed) && !m_output->write(m_buffer + offset, length)) {
+      m_failed.store(true);
+    }
+    tail += length;
+    m_tail.store(tail, std::memory_order_release);
+  }
+}
+
+void BinaryTraceWriter::wait_for_space(size_t size) {
+  while (m_reserved + size - m_cached_tail > m_capacity) {
+    m_cached_tail = m_tail.load(std::memory_order_acquire);
+    if (m_reserved + size - m_cached_tail > m_capacity) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+// Reserve a zeroed record with `payload_size` bytes after the header and
+// return a pointer to the payload. The record becomes visible to the writer
+// thread at end_record().
+uint8_t *BinaryTraceWriter::begin_record(uint8_t kind, size_t payload_size) {
+  const size_t size = align_up(sizeof(RecordHeader) + payload_size);
+  if (size > m_capacity / 2) {
+    throw std::runtime_error("Trace record of " + std::to_string(size) + " bytes does not fit in the trace buffer");
+  }
+
+  // Records are contiguous in the buffer; skip to the start if this one
+  // would wrap.
+  size_t offset = static_cast<size_t>(m_reserved) & (m_capacity - 1);
+  if (m_capacity - offset < size) {
+    const size_t pad = m_capacity - offset;
+    wait_for_space(pad);
+    RecordHeader header = {};
+    header.size = static_cast<uint32_t>(pad);
+    header.kind = RecordKind::Pad;
+    memcpy(m_buffer + offset, &header, sizeof(header));
+    m_reserved += pad;
+    offset = 0;
+  }
+
+  wait_for_space(size);
+  uint8_t *record = m_buffer + offset;
+  memset(record, 0, size);
+  RecordHeader header = {};
+  header.size = static_cast<uint32_t>(size);
+  header.kind = static_cast<RecordKind>(kind);
+  memcpy(record, &header, sizeof(header));
+  m_record_size = size;
+  return record + sizeof(RecordHeader);
+}
+
+void BinaryTraceWriter::end_record() {
+  m_reserved += m_record_size;
+  m_head.store(m_reserved, std::memory_order_release);
+}
+
+uint32_t BinaryTraceWriter::intern(const char *s) {
+  if (s == nullptr) {
+    return no_string;
+  }
+  const std::string_view view(s);
+  const auto it = m_string_ids.find(view);
+  if (it != m_string_ids.end()) {
+    return it->second;
+  }
+
+  const auto id = static_cast<uint32_t>(m_strings.size());
+  const std::string &stored = m_strings.emplace_back(view);
+  m_string_ids.emplace(stored, id);
+
+  StringRecord record = {id, static_cast<uint32_t>(stored.size())};
+  uint8_t *payload = begin_record(static_cast<uint8_t>(RecordKind::String), sizeof(record) + stored.size());
+  memcpy(payload, &record, sizeof(record));
+  memcpy(payload + sizeof(record), stored.data(), stored.size());
+  end_record();
+  return id;
+}
+
+void BinaryTraceWriter::text_record(std::string_view s, bool newline) {
+  TextRecord record = {s.size() + (newline ? 1 : 0)};
+  uint8_t *payload = begin_record(static_cast<uint8_t>(RecordKind::Text), sizeof(record) + record.length);
+  memcpy(payload, &record, sizeof(record));
+  memcpy(payload + sizeof(record), s.data(), s.size());
+  if (newline) {
+    payload[sizeof(record) + s.size()] = '\n';
+  }
+  end_record();
+}
+
+void BinaryTraceWriter::text(std::string_view s) {
+  text_record(s, false);
+}
+
+void BinaryTraceWriter::line(std::string_view s) {
+  text_record(s, true);
+}
+
+void BinaryTraceWriter::instr(const TraceInstr &instr) {
+  const std::string_view disassembly(instr.disassembly);
+  InstrRecord record = {};
+  record.step = instr.step;
+  record.hart = instr.hart;
+  record.pc = instr.pc;
+  record.opcode = instr.opcode;
+  record.symbol_offset = instr.symbol_offset;
+  record.privilege = intern(instr.privilege);
+  record.symbol = intern(instr.symbol);
+  record.disassembly_length = static_cast<uint32_t>(disassembly.size());
+  record.pc_digits = static_cast<uint8_t>(instr.pc_digits);
+  record.opcode_digits = static_cast<uint8_t>(instr.opcode_digits);
+  uint8_t *payload = begin_record(static_cast<uint8_t>(RecordKind::Instr), sizeof(record) + disassembly.size());
+  memcpy(payload, &record, sizeof(record));
+  memcpy(payload + sizeof(record), disassembly.data(), disassembly.size());
+  end_record();
+}
+
+void BinaryTraceWriter::mem_access(
+  const char *type,
+  bool is_write,
+  uint64_t paddr,
+  int paddr_digits,
+  const uint8_t *value,
+  size_t value_bytes,
+  int digits
+) {
+  MemAccessRecord record = {};
+  record.paddr = paddr;
+  record.type = intern(type);
+  record.value_bytes = static_cast<uint32_t>(value_bytes);
+  record.digits = static_cast<uint32_t>(digits);
+  record.paddr_digits = static_cast<uint8_t>(paddr_digits);
+  record.is_write = is_write;
+  uint8_t *payload = begin_record(static_cast<uint8_t>(RecordKind::MemAccess), sizeof(record) + value_bytes);
+  memcpy(payload, &record, sizeof(record));
+  memcpy(payload + sizeof(record), value, value_bytes);
+  end_record();
+}
+
+void BinaryTraceWriter::xreg_write(const char *abi_name, uint64_t reg, uint64_t value, int digits) {
+  const XregWriteRecord record = {value, reg, intern(abi_name), static_cast<uint32_t>(digits)};
+  memcpy(begin_record(static_cast<uint8_t>(RecordKind::XregWrite), sizeof(record)), &record, sizeof(record));
+  end_record();
+}
+
+void BinaryTraceWriter::freg_write(unsigned reg, uint64_t value, int digits) {
+  const FregWriteRecord record = {value, reg, static_cast<uint32_t>(digits)};
+  memcpy(begin_record(static_cast<uint8_t>(RecordKind::FregWrite), sizeof(record)), &record, sizeof(record));
+  end_record();
+}
+
+void BinaryTraceWriter::csr_access(const char *csr_name, unsigned reg, bool is_write, uint64_t value, int digits) {
+  const CsrAccessRecord record = {
+    value,
+    intern(csr_name),
+    static_cast<uint16_t>(reg),
+    is_write,
+    static_cast<uint8_t>(digits),
+  };
+  memcpy(begin_record(static_cast<uint8_t>(RecordKind::CsrAccess), sizeof(record)), &record, sizeof(record));
+  end_record();
+}
+
+void BinaryTraceWriter::vreg_write(unsigned reg, const uint8_t *value, size_t value_bytes, int digits) {
+  const VregWriteRecord record = {reg, static_cast<uint32_t>(value_bytes), static_cast<uint32_t>(digits), 0};
+  uint8_t *payload = begin_record(static_cast<uint8_t>(RecordKind::VregWrite), sizeof(record) + value_bytes);
+  memcpy(payload, &record, sizeof(record));
+  memcpy(payload + sizeof(record), value, value_bytes);
+  end_record();
+}
+
+void BinaryTraceWriter::ptw_start(uint64_t vpn, const char *access_type, const char *privilege) {
+  const PtwStartRecord record = {vpn, intern(access_type), intern(privilege)};
+  memcpy(begin_record(static_cast<uint8_t>(RecordKind::PtwStart), sizeof(record)), &record, sizeof(record));
+  end_record();
+}
+
+void BinaryTraceWriter::ptw_step(int64_t level, uint64_t pte, uint64_t pte_addr) {
+  const PtwStepRecord record = {level, pte, pte_addr};
+  memcpy(begin_record(static_cast<uint8_t>(RecordKind::PtwStep), sizeof(record)), &record, sizeof(record));
+  end_record();
+}
+
+void BinaryTraceWriter::ptw_success(uint64_t final_ppn, int64_t level) {
+  const PtwSuccessRecord record = {final_ppn, level};
+  memcpy(begin_record(static_cast<uint8_t>(RecordKind::PtwSuccess), sizeof(record)), &record, sizeof(record));
+  end_record();
+}
+
+void BinaryTraceWriter::ptw_fail(const char *error, int64_t level, uint64_t pte_addr) {
+  const PtwFailRecord record = {level, pte_addr, intern(error), 0};
+  memcpy(begin_record(static_cast<uint8_t>(RecordKind::PtwFail), sizeof(record)), &record, sizeof(record));
+  end_record();
+}
+
+void BinaryTraceWriter::tlb(const std::vector<TraceTlbEntry> &entries, bool is_flush) {
+  TlbRecord record = {};
+  record.num_entries = static_cast<uint32_t>(entries.size());
+  record.is_flush = is_flush;
+  const size_t entries_size = entries.size() * sizeof(TlbEntryRecord);
+
+  uint8_t *payload = begin_record(static_cast<uint8_t>(RecordKind::Tlb), sizeof(record) + entries_size);
+  memcpy(payload, &record, sizeof(record));
+  uint8_t *p = payload + sizeof(record);
+  for (const auto &entry : entries) {
+    TlbEntryRecord e = {};
+    e.index = entry.index;
+    e.asid = entry.asid;
+    e.vpn = entry.vpn;
+    e.pte = entry.pte;
+    e.level_mask = entry.level_mask;
+    e.ppn = entry.ppn;
+    e.pte_addr = entry.pte_addr;
+    e.global = entry.global;
+    memcpy(p, &e, sizeof(e));
+    p += sizeof(e);
+  }
+  end_record();
+}
+
+namespace {
+
+class BinaryTraceInput {
+public:
+  explicit BinaryTraceInput(const std::string &filename) : m_filename(filename) {
+#ifdef HAVE_ZLIB
+    // gzopen() also reads uncompressed files.
+    m_gz = gzopen(filename.c_str(), "rb");
+    if (m_gz == nullptr) {
+      throw std::runtime_error("Cannot open trace file '" + filename + "': " + strerror(errno));
+    }
+#else
+    m_file = fopen(filename.c_str(), "rb");
+    if (m_file == nullptr) {
+      throw std::runtime_error("Cannot open trace file '" + filename + "': " + strerror(errno));
+    }
+#endif
+  }
+
+  ~BinaryTraceInput() {
+#ifdef HAVE_ZLIB
+    gzclose(m_gz);
+#else
+    fclose(m_file);
+#endif
+  }
+
+  BinaryTraceInput(const BinaryTraceInput &) = delete;
+  BinaryTraceInput &operator=(const BinaryTraceInput &) = delete;
+
+  // Returns the number of bytes read, which is less than `length` only at
+  // the end of the file.
+  size_t read(void *data, size_t length) {
+#ifdef HAVE_ZLIB
+    const size_t n = gzfread(data, 1, length, m_gz);
+    int gz_error = Z_OK;
+    gzerror(m_gz, &gz_error);
+    if (n < length && gz_error != Z_OK && gz_error != Z_BUF_ERROR) {
+      error("read failed");
+    }
+    return n;
+#else
+    return fread(data, 1, length, m_file);
+#endif
+  }
+
+  void read_exact(void *data, size_t length) {
+    if (read(data, length) != length) {
+      error("file is truncated");
+    }
+  }
+
+  [[noreturn]] void error(const std::string &msg) const {
+    throw std::runtime_error("Invalid trace file '" + m_filename + "': " + msg);
+  }
+
+private:
+  std::string m_filename;
+#ifdef HAVE_ZLIB
+  gzFile m_gz = nullptr;
+#else
+  FILE *m_file = nullptr;
+#endif
+};
+
+// Bounds-checked access to the payload of one record.
+class RecordPayload {
+public:
+  RecordPayload(const BinaryTraceInput &input, const std::vector<uint8_t> &data) : m_input(input), m_data(data) {
+  }
+
+  template <typename T> T get() {
+    static_assert(std::is_trivially_copyable_v<T>);
+    T value;
+    memcpy(&value, bytes(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  const uint8_t *bytes(size_t length) {
+    if (length > m_data.size() - m_offset) {
+      m_input.error("record is truncated");
+    }
+    const uint8_t *p = m_data.data() + m_offset;
+    m_offset += length;
+    return p;
+  }
+
+private:
+  const BinaryTraceInput &m_input;
+  const std::vector<uint8_t> &m_data;
+  size_t m_offset = 0;
+};
+
+class TraceDecoder {
+public:
+  TraceDecoder(BinaryTraceInput &input, FILE *out) : m_input(input), m_out(out) {
+  }
+
+  void run() {
+    std::vector<uint8_t> data;
+    for (;;) {
+      RecordHeader header;
+      const size_t n = m_input.read(&header, sizeof(header));
+      if (n == 0) {
+        return;
+      }
+      if (n != sizeof(header)) {
+        m_input.error("file is truncated");
+      }
+      if (header.size < sizeof(header) || header.size % record_alignment != 0 || header.size > max_record_size) {
+        m_input.error("bad record size " + std::to_string(header.size));
+      }
+      data.resize(header.size - sizeof(header));
+      m_input.read_exact(data.data(), data.size());
+      RecordPayload payload(m_input, data);
+      record(header.kind, payload);
+    }
+  }
+
+private:
+  const char *string(uint32_t id) const {
+    if (id == no_string) {
+      return nullptr;
+    }
+    if (id >= m_strings.size()) {
+      m_input.error("undefined string " + std::to_string(id));
+    }
+    return m_strings[id].c_str();
+  }
+
+  void record(RecordKind kind, RecordPayload &payload) {
+    switch (kind) {
+    case RecordKind::Pad:
+      break;
+    case RecordKind::String: {
+      const auto r = payload.get<StringRecord>();
+      if (r.id != m_strings.size()) {
+        m_input.error("unexpected string id " + std::to_string(r.id));
+      }
+      const auto *chars = reinterpret_cast<const char *>(payload.bytes(r.length));
+      m_strings.emplace_back(chars, r.length);
+      break;
+    }
+    case RecordKind::Text: {
+      const auto r = payload.get<TextRecord>();
+      fwrite(payload.bytes(r.length), 1, r.length, m_out);
+      break;
+    }
+    case RecordKind::Instr: {
+      const auto r = payload.get<InstrRecord>();
+      const auto *chars = reinterpret_cast<const char *>(payload.bytes(r.disassembly_length));
+      const std::string disassembly(chars, r.disassembly_length);
+      TraceInstr instr;
+      instr.step = r.step;
+      instr.hart = r.hart;
+      instr.privilege = string(r.privilege);
+      instr.pc = r.pc;
+      instr.pc_digits = r.pc_digits;
+      instr.opcode = r.opcode;
+      instr.opcode_digits = r.opcode_digits;
+      instr.disassembly = disassembly.c_str();
+      instr.symbol = string(r.symbol);
+      instr.symbol_offset = r.symbol_offset;
+      print_instr(m_out, instr);
+      break;
+    }
+    case RecordKind::MemAccess: {
+      const auto r = payload.get<MemAccessRecord>();
+      const uint8_t *value = payload.bytes(r.value_bytes);
+      print_mem_access(
+        m_out,
+        string(r.type),
+        r.is_write,
+        r.paddr,
+        r.paddr_digits,
+        value,
+        r.value_bytes,
+        static_cast<int>(r.digits)
+      );
+      break;
+    }
+    case RecordKind::XregWrite: {
+      const auto r = payload.get<XregWriteRecord>();
+      print_xreg_write(m_out, string(r.abi_name), r.reg, r.value, static_cast<int>(r.digits));
+      break;
+    }
+    case RecordKind::FregWrite: {
+      const auto r = payload.get<FregWriteRecord>();
+      print_freg_write(m_out, r.reg, r.value, static_cast<int>(r.digits));
+      break;
+    }
+    case RecordKind::CsrAccess: {
+      const auto r = payload.get<CsrAccessRecord>();
+      print_csr_access(m_out, string(r.csr_name), r.reg, r.is_write, r.value, r.digits);
+      break;
+    }
+    case RecordKind::VregWrite: {
+      const auto r = payload.get<VregWriteRecord>();
+      const uint8_t *value = payload.bytes(r.value_bytes);
+      print_vreg_write(m_out, r.reg, value, r.value_bytes, static_cast<int>(r.digits));
+      break;
+    }
+    case RecordKind::PtwStart: {
+      const auto r = payload.get<PtwStartRecord>();
+      print_ptw_start(m_out, r.vpn, string(r.access_type), string(r.privilege));
+      break;
+    }
+    case RecordKind::PtwStep: {
+      const auto r = payload.get<PtwStepRecord>();
+      print_ptw_step(m_out, r.level, r.pte, r.pte_addr);
+      break;
+    }
+    case RecordKind::PtwSuccess: {
+      const auto r = payload.get<PtwSuccessRecord>();
+      print_ptw_success(m_out, r.final_ppn, r.level);
+      break;
+    }
+    case RecordKind::PtwFail: {
+      const auto r = payload.get<PtwFailRecord>();
+      print_ptw_fail(m_out, string(r.error), r.level, r.pte_addr);
+      break;
+    }
+    case RecordKind::Tlb: {
+      const auto r = payload.get<TlbRecord>();
+      std::vector<TraceTlbEntry> entries(r.num_entries);
+      for (auto &entry : entries) {
+        const auto e = payload.get<TlbEntryRecord>();
+        entry.index = e.index;
+        entry.global = e.global != 0;
+        entry.asid = e.asid;
+        entry.vpn = e.vpn;
+        entry.pte = e.pte;
+        entry.level_mask = e.level_mask;
+        entry.ppn = e.ppn;
+        entry.pte_addr = e.pte_addr;
+      }
+      print_tlb(m_out, entries, r.is_flush);
+      break;
+    }
+    default:
+      m_input.error("unknown record kind " + std::to_string(static_cast<unsigned>(kind)));
+    }
+  }
+
+  BinaryTraceInput &m_input;
+  FILE *m_out;
+  std::vector<std::string> m_strings;
+};
+
+} // namespace
+
+void decode_binary_trace(const std::string &filename, FILE *out) {
+  BinaryTraceInput input(filename);
+
+  FileHeader header;
+  input.read_exact(&header, sizeof(header));
+  if (memcmp(header.magic, trace_magic, sizeof(header.magic)) != 0) {
+#ifndef HAVE_ZLIB
+    if (static_cast<uint8_t>(header.magic[0]) == 0x1f && static_cast<uint8_t>(header.magic[1]) == 0x8b) {
+      input.error("the trace is compressed but this tool was built without zlib");
+    }
+#endif
+    input.error("not a binary trace");
+  }
+  if (header.version != trace_version) {
+    input.error("unsupported version " + std::to_string(header.version));
+  }
+  if (header.byte_order_mark != trace_byte_order_mark) {
+    input.error("written on a host with a different byte order");
+  }
+
+  TraceDecoder(input, out).run();
+}
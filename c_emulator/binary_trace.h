@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "trace_format.h"
+
+class BinaryTraceOutput;
+
+// Writes trace events as compact binary records. Records are appended to a
+// single-producer single-consumer ring buffer by the simulation thread and
+// written to the file by a background thread, so the simulation only pays
+// for copying a few words per event. Names (CSRs, access types, etc.) are
+// written once and then referred to by index.
+//
+// The file can be turned back into the text trace with
+// decode_binary_trace() (or the `sail_riscv_trace_decode` tool).
+class BinaryTraceWriter : public TraceSink {
+public:
+  static constexpr size_t default_buffer_size = size_t{4} << 20;
+
+  // Create `filename`, optionally gzip compressed. Throws an exception if
+  // the file cannot be created or compression is not available.
+  BinaryTraceWriter(const std::string &filename, bool compress, size_t buffer_size = default_buffer_size);
+  ~BinaryTraceWriter() override;
+
+  BinaryTraceWriter(const BinaryTraceWriter &) = delete;
+  BinaryTraceWriter &operator=(const BinaryTraceWriter &) = delete;
+
+  // TraceSink. Each event is one record, which the decoder prints with the
+  // corresponding print_*() function in trace_format.h.
+  void text(std::string_view s) override;
+  void line(std::string_view s) override;
+  void instr(const TraceInstr &instr) override;
+  void mem_access(
+    const char *type,
+    bool is_write,
+    uint64_t paddr,
+    int paddr_digits,
+    const uint8_t *value,
+    size_t value_bytes,
+    int digits
+  ) override;
+  void xreg_write(const char *abi_name, uint64_t reg, uint64_t value, int digits) override;
+  void freg_write(unsigned reg, uint64_t value, int digits) override;
+  void csr_access(const char *csr_name, unsigned reg, bool is_write, uint64_t value, int digits) override;
+  void vreg_write(unsigned reg, const uint8_t *value, size_t value_bytes, int digits) override;
+  void ptw_start(uint64_t vpn, const char *access_type, const char *privilege) override;
+  void ptw_step(int64_t level, uint64_t pte, uint64_t pte_addr) override;
+  void ptw_success(uint64_t final_ppn, int64_t level) override;
+  void ptw_fail(const char *error, int64_t level, uint64_t pte_addr) override;
+  void tlb(const std::vector<TraceTlbEntry> &entries, bool is_flush) override;
+
+  // Write out everything that is buffered and close the file. Throws an
+  // exception if any of the trace could not be written.
+  void close();
+
+private:
+  uint8_t *begin_record(uint8_t kind, size_t payload_size);
+  void end_record();
+  void wait_for_space(size_t size);
+  void text_record(std::string_view s, bool newline);
+  uint32_t intern(const char *s);
+  void stop();
+  void drain();
+
+  std::unique_ptr<BinaryTraceOutput> m_output;
+  std::unique_ptr<uint64_t[]> m_storage;
+  uint8_t *m_buffer = nullptr;
+  size_t m_capacity = 0;
+
+  // Producer state. m_head is only written by the simulation thread and
+  // m_tail only by the writer thread; they are kept on separate cache
+  // lines so the two threads don't contend for them.
+  alignas(64) std::atomic<uint64_t> m_head{0};
+  uint64_t m_reserved = 0;
+  uint64_t m_cached_tail = 0;
+  size_t m_record_size = 0;
+
+  alignas(64) std::atomic<uint64_t> m_tail{0};
+
+  alignas(64) std::atomic<bool> m_stop{false};
+  std::atomic<bool> m_failed{false};
+  std::thread m_thread;
+
+  std::deque<std::string> m_strings;
+  std::unordered_map<std::string_view, uint32_t> m_string_ids;
+};
+
+// Print the binary trace in `filename` in the text trace format. Throws an
+// exception if the file cannot be read or is not a valid trace.
+void decode_binary_trace(const std::string &filename, FILE *out);
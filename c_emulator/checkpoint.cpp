@@ -0,0 +1,224 @@
+#include "checkpoint.h"
+#include "riscv_model_impl.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+// Checkpoint file layout. All integers are 64-bit little-endian.
+//
+//   magic "SAILCKPT", version
+//   instruction count
+//   register count, then for each register:
+//     name length, name, bit length, (bit length + 7) / 8 value bytes
+//   region count, then for each main memory region:
+//     base, size, then for each non-zero page:
+//       offset within the region, page bytes (less for a final partial page)
+//     page_end_marker
+
+namespace {
+
+constexpr char checkpoint_magic[8] = {'S', 'A', 'I', 'L', 'C', 'K', 'P', 'T'};
+constexpr uint64_t checkpoint_version = 1;
+constexpr uint64_t checkpoint_page_size = 4096;
+constexpr uint64_t page_end_marker = UINT64_MAX;
+constexpr uint64_t max_name_len = 256;
+constexpr uint64_t max_bit_len = 65536;
+
+class CheckpointWriter {
+public:
+  explicit CheckpointWriter(const std::string &filename) : m_filename(filename) {
+    m_file = fopen(filename.c_str(), "wb");
+    if (m_file == nullptr) {
+      throw std::runtime_error("Cannot create checkpoint '" + filename + "': " + strerror(errno));
+    }
+  }
+
+  ~CheckpointWriter() {
+    if (m_file != nullptr) {
+      fclose(m_file);
+    }
+  }
+
+  CheckpointWriter(const CheckpointWriter &) = delete;
+  CheckpointWriter &operator=(const CheckpointWriter &) = delete;
+
+  void bytes(const void *data, size_t length) {
+    if (fwrite(data, 1, length, m_file) != length) {
+      throw std::runtime_error("Could not write checkpoint '" + m_filename + "': " + strerror(errno));
+    }
+  }
+
+  void u64(uint64_t value) {
+    uint8_t buf[8];
+    for (unsigned i = 0; i < 8; ++i) {
+      buf[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+    bytes(buf, sizeof(buf));
+  }
+
+  void close() {
+    FILE *file = m_file;
+    m_file = nullptr;
+    if (fclose(file) != 0) {
+      throw std::runtime_error("Could not write checkpoint '" + m_filename + "': " + strerror(errno));
+    }
+  }
+
+private:
+  std::string m_filename;
+  FILE *m_file = nullptr;
+};
+
+class CheckpointReader {
+public:
+  explicit CheckpointReader(const std::string &filename) : m_filename(filename) {
+    m_file = fopen(filename.c_str(), "rb");
+    if (m_file == nullptr) {
+      throw std::runtime_error("Cannot open checkpoint '" + filename + "': " + strerror(errno));
+    }
+  }
+
+  ~CheckpointReader() {
+    fclose(m_file);
+  }
+
+  CheckpointReader(const CheckpointReader &) = delete;
+  CheckpointReader &operator=(const CheckpointReader &) = delete;
+
+  void bytes(void *data, size_t length) {
+    if (fread(data, 1, length, m_file) != length) {
+      error("file is truncated");
+    }
+  }
+
+  uint64_t u64() {
+    uint8_t buf[8];
+    bytes(buf, sizeof(buf));
+    uint64_t value = 0;
+    for (unsigned i = 0; i < 8; ++i) {
+      value |= static_cast<uint64_t>(buf[i]) << (8 * i);
+    }
+    return value;
+  }
+
+  [[noreturn]] void error(const std::string &msg) const {
+    throw std::runtime_error("Invalid checkpoint '" + m_filename + "': " + msg);
+  }
+
+private:
+  std::string m_filename;
+  FILE *m_file = nullptr;
+};
+
+void save_region(CheckpointWriter &writer, ModelImpl &model, const MemoryRegion &region) {
+  writer.u64(region.base);
+  writer.u64(region.size);
+
+  std::vector<uint8_t> page(checkpoint_page_size);
+  for (uint64_t offset = 0; offset < region.size; offset += checkpoint_page_size) {
+    const uint64_t length = std::min(checkpoint_page_size, region.size - offset);
+    model.read_mem_bytes(region.base + offset, page.data(), length);
+    if (std::all_of(page.begin(), page.begin() + static_cast<ptrdiff_t>(length), [](uint8_t b) { return b == 0; })) {
+      continue;
+    }
+    writer.u64(offset);
+    writer.bytes(page.data(), static_cast<size_t>(length));
+  }
+  writer.u64(page_end_marker);
+}
+
+void restore_region(CheckpointReader &reader, ModelImpl &model, const MemoryRegion &region) {
+  const uint64_t base = reader.u64();
+  const uint64_t size = reader.u64();
+  if (base != region.base || size != region.size) {
+    reader.error("memory regions do not match the configuration");
+  }
+
+  model.zero_mem_bytes(region.base, region.size);
+
+  std::vector<uint8_t> page(checkpoint_page_size);
+  for (uint64_t offset = reader.u64(); offset != page_end_marker; offset = reader.u64()) {
+    if (offset >= region.size || offset % checkpoint_page_size != 0) {
+      reader.error("bad page offset " + std::to_string(offset));
+    }
+    const uint64_t length = std::min(checkpoint_page_size, region.size - offset);
+    reader.bytes(page.data(), static_cast<size_t>(length));
+    model.write_mem_bytes(region.base + offset, page.data(), length);
+  }
+}
+
+} // namespace
+
+void save_checkpoint(ModelImpl &model, const std::string &filename, uint64_t instructions) {
+  CheckpointWriter writer(filename);
+
+  writer.bytes(checkpoint_magic, sizeof(checkpoint_magic));
+  writer.u64(checkpoint_version);
+  writer.u64(instructions);
+
+  const CheckpointRegisters registers = model.save_registers();
+  writer.u64(registers.size());
+  for (const auto &[name, value] : registers) {
+    writer.u64(name.size());
+    writer.bytes(name.data(), name.size());
+    writer.u64(value.bit_len);
+    writer.bytes(value.bytes.data(), value.bytes.size());
+  }
+
+  const std::vector<MemoryRegion> regions = model.main_memory_regions();
+  writer.u64(regions.size());
+  for (const auto &region : regions) {
+    save_region(writer, model, region);
+  }
+
+  writer.close();
+}
+
+uint64_t restore_checkpoint(ModelImpl &model, const std::string &filename) {
+  CheckpointReader reader(filename);
+
+  char magic[sizeof(checkpoint_magic)];
+  reader.bytes(magic, sizeof(magic));
+  if (memcmp(magic, checkpoint_magic, sizeof(magic)) != 0) {
+    reader.error("not a checkpoint file");
+  }
+  const uint64_t version = reader.u64();
+  if (version != checkpoint_version) {
+    reader.error("unsupported version " + std::to_string(version));
+  }
+  const uint64_t instructions = reader.u64();
+
+  CheckpointRegisters registers;
+  const uint64_t num_registers = reader.u64();
+  for (uint64_t i = 0; i < num_registers; ++i) {
+    const uint64_t name_len = reader.u64();
+    if (name_len > max_name_len) {
+      reader.error("bad register name length " + std::to_string(name_len));
+    }
+    std::string name(name_len, '\0');
+    reader.bytes(name.data(), name.size());
+    CheckpointValue value;
+    value.bit_len = reader.u64();
+    if (value.bit_len == 0 || value.bit_len > max_bit_len) {
+      reader.error("bad bit length " + std::to_string(value.bit_len) + " for '" + name + "'");
+    }
+    value.bytes.resize((value.bit_len + 7) / 8);
+    reader.bytes(value.bytes.data(), value.bytes.size());
+    registers.emplace(std::move(name), std::move(value));
+  }
+
+  const std::vector<MemoryRegion> regions = model.main_memory_regions();
+  if (reader.u64() != regions.size()) {
+    reader.error("memory regions do not match the configuration");
+  }
+  for (const auto &region : regions) {
+    restore_region(reader, model, region);
+  }
+
+  model.restore_registers(registers);
+
+  return instructions;
+}
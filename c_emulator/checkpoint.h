@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+class ModelImpl;
+
+// A named piece of model state: an unsigned bitvector stored as
+// little-endian bytes.
+struct CheckpointValue {
+  uint64_t bit_len = 0;
+  std::vector<uint8_t> bytes;
+};
+
+using CheckpointRegisters = std::map<std::string, CheckpointValue>;
+
+// Save the model state and the contents of the main memory regions to
+// `filename`. Memory is stored sparsely: pages that are entirely zero are
+// omitted. Throws an exception on failure.
+void save_checkpoint(ModelImpl &model, const std::string &filename, uint64_t instructions);
+
+// Restore a checkpoint written by save_checkpoint() and return the number
+// of instructions that had been executed when it was saved. The model must
+// already be initialized with the same configuration and ELF files. Throws
+// an exception if the checkpoint is invalid or doesn't match the model.
+uint64_t restore_checkpoint(ModelImpl &model, const std::string &filename);
@@ -35,6 +35,21 @@ CLIOptions parse_cli(int argc, char **argv) {
     opts.disable_trap_loop_detection,
     "Disable detection of potentially infinite trap loops"
   );
+  app.add_flag(
+    "--single-step-loop",
+    opts.single_step_loop,
+    "Return to the simulator loop after every instruction instead of running bursts in the model (slower)"
+  );
+  app.add_flag(
+    "--host-fpu",
+    opts.host_fpu,
+    "Use the host FPU for single and double precision arithmetic where it gives the same results as softfloat"
+  );
+  app.add_flag(
+    "--no-host-vregs",
+    opts.no_host_vregs,
+    "Keep the vector registers in the model's arbitrary-precision registers instead of host buffers (slower)"
+  );
 
   app.add_option("--device-tree-blob", opts.dtb_file, "Device tree blob file")
     ->check(CLI::ExistingFile)
@@ -56,6 +71,16 @@ CLIOptions parse_cli(int argc, char **argv) {
     ->option_text("<file>")
     ->allow_extra_args(false);
   app.add_option("--trace-output", opts.trace_log_path, "Trace output file")->option_text("<file>");
+  app
+    .add_option(
+      "--trace-format",
+      opts.trace_format,
+      "Trace output format. Binary traces are much faster to write and can be converted to text with "
+      "sail_riscv_trace_decode"
+    )
+    ->check(CLI::IsMember({"text", "binary"}))
+    ->option_text("<text|binary>");
+  app.add_flag("--trace-compress", opts.trace_compress, "Compress the binary trace output with gzip");
 
   app.add_option("--signature-granularity", opts.signature_granularity, "Signature granularity")
     ->option_text("<uint>")
@@ -65,6 +90,25 @@ CLIOptions parse_cli(int argc, char **argv) {
     ->option_text("<int> (within [1 - 65535])");
   app.add_option("--inst-limit", opts.insn_limit, "Instruction limit")->option_text("<uint>");
   app.add_option("--stop-at-pc", opts.stop_at_pc, "Stop execution when PC reaches address")->option_text("<address>");
+  app
+    .add_option(
+      "--profile",
+      opts.profile_path,
+      "Sample the PC and call stack of every hart and write a flat profile to this file, and the call stacks in "
+      "the folded format of flame graph tools to this file with a .folded suffix"
+    )
+    ->option_text("<file>");
+  app.add_option("--profile-interval", opts.profile_interval, "Retired instructions between profile samples")
+    ->option_text("<uint>")
+    ->check(CLI::PositiveNumber);
+  app
+    .add_option(
+      "--stats-json",
+      opts.stats_json_path,
+      "Write the counts of retired instructions by mnemonic, extension and privilege mode, and of traps by cause, "
+      "to this file as JSON"
+    )
+    ->option_text("<file>");
 #ifdef SAILCOV
   app.add_option("--sailcov-file", opts.sailcov_file, "Sail coverage output file")->option_text("<file>");
 #endif
@@ -154,6 +198,27 @@ CLIOptions parse_cli(int argc, char **argv) {
     ->excludes("--rvfi-dii")
     ->excludes("--inst-limit");
 
+  app
+    .add_option(
+      "--save-checkpoint",
+      opts.save_checkpoint_file,
+      "Save the model state and memory to a checkpoint file when the simulation stops (e.g. at --inst-limit or "
+      "--stop-at-pc)"
+    )
+    ->option_text("<file>")
+    ->excludes("--rvfi-dii")
+    ->excludes("--gdb-server-port");
+  app
+    .add_option(
+      "--restore-checkpoint",
+      opts.restore_checkpoint_file,
+      "Restore the model state and memory from a checkpoint file before running. The configuration and ELF files "
+      "must be the same as when it was saved"
+    )
+    ->check(CLI::ExistingFile)
+    ->option_text("<file>")
+    ->excludes("--rvfi-dii");
+
   // All positional arguments are treated as ELF files.  All ELF files
   // are loaded into memory, but only the first is scanned for the
   // magic `tohost/{begin,end}_signature` symbols.
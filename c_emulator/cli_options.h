@@ -6,6 +6,7 @@
 #include <vector>
 
 const unsigned DEFAULT_SIGNATURE_GRANULARITY = 4;
+const uint64_t DEFAULT_PROFILE_INTERVAL = 10000;
 
 struct CLIOptions {
   bool do_show_times = false;
@@ -21,16 +22,26 @@ struct CLIOptions {
 
   bool use_rv32_default = false;
   bool disable_trap_loop_detection = false;
+  bool single_step_loop = false;
+  bool host_fpu = false;
+  bool no_host_vregs = false;
   std::string config_file = {};
   std::vector<std::string> config_overrides = {};
   std::string term_log = {};
   std::string trace_log_path = {};
+  std::string trace_format = "text";
+  bool trace_compress = false;
   std::string dtb_file;
   unsigned rvfi_dii_port = 0;
   unsigned gdb_server_port = 0;
   std::vector<std::string> elfs;
   uint64_t insn_limit = 0;
   std::optional<uint64_t> stop_at_pc;
+  std::string profile_path = {};
+  uint64_t profile_interval = DEFAULT_PROFILE_INTERVAL;
+  std::string stats_json_path = {};
+  std::string save_checkpoint_file = {};
+  std::string restore_checkpoint_file = {};
 
   std::string sig_file = {};
   unsigned signature_granularity = DEFAULT_SIGNATURE_GRANULARITY;
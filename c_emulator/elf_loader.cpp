@@ -36,7 +36,7 @@ uint64_t ELF::entry() const {
   return m_reader->get_entry();
 }
 
-void ELF::load(std::function<void(uint64_t, const uint8_t *, uint64_t)> writer) const {
+void ELF::load(ElfWriteFn writer, ElfZeroFn zeroer) const {
   for (const auto &seg : m_reader->segments) {
     if (seg->get_type() == ELFIO::PT_LOAD) {
       // It's a segment that we should load into memory.
@@ -52,17 +52,16 @@ void ELF::load(std::function<void(uint64_t, const uint8_t *, uint64_t)> writer)
       // If the memory size is greater than the file size the remaining
       // bytes should be zeroed.
       if (seg->get_memory_size() > seg->get_file_size()) {
-        std::vector<uint8_t> zeros(seg->get_memory_size() - seg->get_file_size(), 0);
-        writer(seg->get_physical_address() + seg->get_file_size(), zeros.data(), zeros.size());
+        zeroer(seg->get_physical_address() + seg->get_file_size(), seg->get_memory_size() - seg->get_file_size());
       }
     }
   }
 }
 
-std::map<std::string, uint64_t> ELF::symbols() const {
+std::map<std::string, ELF::SymbolInfo> ELF::symbols() const {
   using namespace ELFIO;
 
-  std::map<std::string, uint64_t> symbolMap;
+  std::map<std::string, SymbolInfo> symbolMap;
 
   const section *symtab = m_reader->sections[".symtab"];
   if (symtab != nullptr) {
@@ -79,7 +78,7 @@ std::map<std::string, uint64_t> ELF::symbols() const {
     while (accessor.get_symbol(index, name, value, size, bind, type, section_index, other)) {
       if ((type == STT_NOTYPE || type == STT_FUNC || type == STT_OBJECT || type == STT_COMMON) &&
           section_index != SHN_UNDEF) {
-        symbolMap[name] = value;
+        symbolMap[name] = {value, size};
       }
       ++index;
     }
@@ -31,15 +31,28 @@ public:
     uint64_t         // length
   )>;
 
+  using ElfZeroFn = std::function<void(
+    uint64_t, // address
+    uint64_t  // length
+  )>;
+
   // Call `writer()` to load all of the loadable sections into memory (or you
-  // can do anything else with them).
-  void load(ElfWriteFn writer) const;
+  // can do anything else with them). Each segment is passed in a single call.
+  // `zeroer()` is called for the part of a segment that is not backed by the
+  // file (e.g. .bss) and must be zero-filled.
+  void load(ElfWriteFn writer, ElfZeroFn zeroer) const;
+
+  struct SymbolInfo {
+    uint64_t value;
+    // 0 if the symbol has no size.
+    uint64_t size;
+  };
 
   // Load and return the symbol table. It isn't cached - every time you call
   // this the entire symbol table is loaded from disk. Note only STT_FUNC,
   // STT_OBJECT, STT_COMMON and STT_NOTYPE symbols that are not SHN_UNDEF are
   // returned.
-  std::map<std::string, uint64_t> symbols() const;
+  std::map<std::string, SymbolInfo> symbols() const;
 
 private:
   explicit ELF(std::unique_ptr<ELFIO::elfio> reader);
@@ -3,6 +3,8 @@
 #include "gdb_run_info.h"
 #include "parse_utils.h"
 #include "responses.h"
+#include <algorithm>
+#include <cinttypes>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
@@ -184,6 +186,11 @@ void protocol_handler::send_stop_reply() {
     return;
   }
 
+  if (m_run_info.enable_trace) {
+    const uint64_t pc = m_model.pc();
+    fprintf(m_run_info.trace_log, "Stopped at 0x%" PRIx64 " %s\n", pc, m_model.elf_symbols().describe(pc).c_str());
+  }
+
   // Simulate being stopped by a breakpoint.
   send_response("S05");
 }
@@ -259,19 +266,47 @@ void protocol_handler::start_continue() {
   });
 }
 
+bool protocol_handler::continue_should_stop() const {
+  return m_has_trapped || m_triggered || (m_interrupt_count > 0) || m_model.htif_done() || m_model.had_exception();
+}
+
 void protocol_handler::continue_continue() {
-  if (m_has_trapped || m_triggered || (m_interrupt_count > 0) || m_model.htif_done() || m_model.had_exception()) {
+  if (continue_should_stop()) {
     end_continue();
     return;
   }
 
   auto parent(m_connection.shared_from_this());
   asio::post(m_executor, [parent, this]() {
-    do_step();
+    continue_burst();
     continue_continue();
   });
 }
 
+// Executing each step in its own handler is very slow, so steps are run in
+// bursts. Control returns to the executor between bursts so that incoming
+// data, in particular Ctrl-C, is still handled. The burst size is adjusted
+// so that a burst takes about `target_burst_time`.
+void protocol_handler::continue_burst() {
+  const auto start = std::chrono::steady_clock::now();
+  uint64_t steps = 0;
+  while (steps < m_burst_steps && !continue_should_stop()) {
+    do_step();
+    ++steps;
+  }
+  if (steps < m_burst_steps) {
+    // Stopped early; the time says nothing about the burst size.
+    return;
+  }
+
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  if (elapsed > target_burst_time) {
+    m_burst_steps = std::max(m_burst_steps / 2, min_burst_steps);
+  } else if (elapsed < target_burst_time / 2) {
+    m_burst_steps = std::min(m_burst_steps * 2, max_burst_steps);
+  }
+}
+
 void protocol_handler::end_continue() {
   send_stop_reply();
 
@@ -6,6 +6,7 @@
 #include "riscv_model_impl.h"
 #include "triggers.h"
 #include <asio.hpp>
+#include <chrono>
 #include <deque>
 #include <set>
 #include <string>
@@ -84,9 +85,14 @@ public:
   void do_step();
   void start_continue();
   void continue_continue();
+  void continue_burst();
   void end_continue();
+  bool continue_should_stop() const;
 
   // Callbacks
+  callback_event_mask subscribed_events() const override {
+    return overridden_callback_events<protocol_handler>();
+  }
   void trap_callback(ModelImpl &, bool is_interrupt, fbits cause) override;
   void mem_write_callback(ModelImpl &model, const char *type, sbits paddr, int64_t width, lbits value) override;
   void mem_read_callback(ModelImpl &model, const char *type, sbits paddr, int64_t width, lbits value) override;
@@ -126,6 +132,13 @@ private:
   bool m_triggered = false;
   bool m_in_continue = false;
 
+  // Steps executed per handler during a continue. This is adapted to the
+  // speed of the model so that Ctrl-C is handled well within 50ms.
+  static constexpr auto target_burst_time = std::chrono::milliseconds(10);
+  static constexpr uint64_t min_burst_steps = 1;
+  static constexpr uint64_t max_burst_steps = uint64_t{1} << 24;
+  uint64_t m_burst_steps = 1024;
+
   // triggers
   class triggers m_triggers;
 };
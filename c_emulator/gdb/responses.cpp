@@ -164,10 +164,11 @@ void qXfer_features_read::dispatch(protocol_handler &proto_handler, gdb_run_info
 }
 
 void read_memory::dispatch(protocol_handler &proto_handler, gdb_run_info &) {
+  ModelImpl &model = proto_handler.get_model();
   std::ostringstream buf;
   buf << std::hex << std::setfill('0');
   for (uint64_t ptr = m_addr; ptr < m_addr + m_length; ++ptr) {
-    unsigned byte = static_cast<unsigned>(read_mem(ptr)) & 0xff;
+    unsigned byte = model.read_mem_byte(ptr);
     buf << std::setw(2) << byte;
   }
   proto_handler.send_response(buf.str());
@@ -191,6 +192,7 @@ void forward_continue::dispatch(protocol_handler &proto_handler, gdb_run_info &)
 }
 
 void write_binary_data::dispatch(protocol_handler &proto_handler, gdb_run_info &info) {
+  ModelImpl &model = proto_handler.get_model();
   std::ostringstream buf;
   buf << std::hex << std::setfill('0');
   for (uint64_t i = 0; i < m_length; ++i) {
@@ -199,7 +201,7 @@ void write_binary_data::dispatch(protocol_handler &proto_handler, gdb_run_info &
       buf << "mem[" << std::setw(16) << (m_addr + i) << "] <-- " << std::setw(2) << static_cast<uint64_t>(byte)
           << std::endl;
     }
-    write_mem(m_addr + i, byte);
+    model.write_mem_byte(m_addr + i, byte);
   }
   if (info.enable_trace) {
     fprintf(info.trace_log, "%s", buf.str().c_str());
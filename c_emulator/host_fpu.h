@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cfenv>
+#include <cfloat>
+#include <cstdint>
+
+// Helpers for computing floating point results on the host FPU with the same
+// results and flags as softfloat. See `--host-fpu`.
+
+// The host FPU can only be used if it rounds float and double operations
+// directly to their own precision and supports the directed rounding modes.
+#if FLT_EVAL_METHOD == 0 && defined(FE_TONEAREST) && defined(FE_TOWARDZERO) && defined(FE_DOWNWARD) &&                \
+  defined(FE_UPWARD) && defined(FE_INEXACT) && defined(FE_UNDERFLOW) && defined(FE_OVERFLOW) &&                        \
+  defined(FE_DIVBYZERO) && defined(FE_INVALID)
+#define HOST_FPU_SUPPORTED 1
+#else
+#define HOST_FPU_SUPPORTED 0
+#endif
+
+#if HOST_FPU_SUPPORTED
+
+// The host rounding mode for a RISC-V rounding mode, or -1 for RMM (round
+// to nearest, ties to max magnitude), which hosts don't have.
+inline int host_rounding_mode(uint64_t rm) {
+  switch (rm) {
+  case 0b000:
+    return FE_TONEAREST;
+  case 0b001:
+    return FE_TOWARDZERO;
+  case 0b010:
+    return FE_DOWNWARD;
+  case 0b011:
+    return FE_UPWARD;
+  default:
+    return -1;
+  }
+}
+
+// Host exceptions after which the result can't be trusted, so softfloat
+// must be used instead:
+//
+// - Invalid, which produces a NaN, whose payload (and whether it is
+//   canonical) differs between hosts and RISC-V.
+// - Underflow. RISC-V detects tininess after rounding, as does x86, but Arm
+//   detects it before rounding, so the underflow flag can differ.
+//
+// NaN results without the invalid exception (from NaN operands) have to
+// be checked for separately.
+constexpr int host_fpu_fallback_exceptions = FE_INVALID | FE_UNDERFLOW;
+
+// The RISC-V fflags (which softfloat uses too) for the other host
+// exceptions.
+inline uint64_t fflags_of_host_exceptions(int raised) {
+  uint64_t flags = 0;
+  if ((raised & FE_INEXACT) != 0) {
+    flags |= 0b00001;
+  }
+  if ((raised & FE_OVERFLOW) != 0) {
+    flags |= 0b00100;
+  }
+  if ((raised & FE_DIVBYZERO) != 0) {
+    flags |= 0b01000;
+  }
+  return flags;
+}
+
+#endif
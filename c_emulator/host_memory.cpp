@@ -0,0 +1,107 @@
+#include "host_memory.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+uint8_t *map_anonymous(uint64_t size) {
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+  // Don't reserve swap for the whole region; most of it is never touched.
+  flags |= MAP_NORESERVE;
+#endif
+  void *data = mmap(nullptr, static_cast<size_t>(size), PROT_READ | PROT_WRITE, flags, -1, 0);
+  if (data == MAP_FAILED) {
+    throw std::runtime_error("Unable to map " + std::to_string(size) + " bytes of host memory: " + strerror(errno));
+  }
+  return static_cast<uint8_t *>(data);
+}
+
+} // namespace
+
+HostMemory::~HostMemory() {
+  unmap_all();
+}
+
+void HostMemory::map_regions(const std::vector<MemoryRegion> &regions) {
+  std::vector<MemoryRegion> merged;
+  for (const auto &region : regions) {
+    if (region.size != 0) {
+      merged.push_back(region);
+    }
+  }
+  std::sort(merged.begin(), merged.end(), [](const MemoryRegion &a, const MemoryRegion &b) {
+    return a.base < b.base;
+  });
+  size_t count = 0;
+  for (const auto &region : merged) {
+    if (count != 0 && region.base - merged[count - 1].base <= merged[count - 1].size) {
+      MemoryRegion &last = merged[count - 1];
+      last.size = std::max(last.size, region.base - last.base + region.size);
+    } else {
+      merged[count++] = region;
+    }
+  }
+  merged.resize(count);
+
+  std::vector<MappedRegion> mapped;
+  for (const auto &region : merged) {
+    auto existing = std::find_if(m_regions.begin(), m_regions.end(), [&](const MappedRegion &r) {
+      return r.base == region.base && r.size == region.size;
+    });
+    if (existing != m_regions.end()) {
+      mapped.push_back(*existing);
+      existing->data = nullptr;
+    } else {
+      mapped.push_back({region.base, region.size, map_anonymous(region.size)});
+    }
+  }
+  unmap_all();
+  m_regions = std::move(mapped);
+}
+
+void HostMemory::zero(uint8_t *ptr, uint64_t size) {
+#ifdef __linux__
+  const auto page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+  const auto begin = reinterpret_cast<uintptr_t>(ptr);
+  const uintptr_t end = begin + size;
+  const uintptr_t page_begin = (begin + page_size - 1) & ~(page_size - 1);
+  const uintptr_t page_end = end & ~(page_size - 1);
+
+  // On Linux, MADV_DONTNEED on a private anonymous mapping replaces the
+  // pages with zero-fill-on-demand pages.
+  if (page_begin < page_end &&
+      madvise(reinterpret_cast<void *>(page_begin), page_end - page_begin, MADV_DONTNEED) == 0) {
+    memset(ptr, 0, page_begin - begin);
+    memset(reinterpret_cast<void *>(page_end), 0, end - page_end);
+    return;
+  }
+#endif
+  memset(ptr, 0, static_cast<size_t>(size));
+}
+
+uint8_t *HostMemory::lookup(uint64_t addr, uint64_t size) {
+  for (const auto &region : m_regions) {
+    if (region.contains(addr, size)) {
+      m_last_hit = &region;
+      return region.data + (addr - region.base);
+    }
+  }
+  return nullptr;
+}
+
+void HostMemory::unmap_all() {
+  for (const auto &region : m_regions) {
+    if (region.data != nullptr) {
+      munmap(region.data, static_cast<size_t>(region.size));
+    }
+  }
+  m_regions.clear();
+  m_last_hit = nullptr;
+}
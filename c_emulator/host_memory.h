@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct MemoryRegion {
+  uint64_t base = 0;
+  uint64_t size = 0;
+};
+
+// Physical memory backed by host allocations. Adjacent or overlapping
+// regions are merged, and each merged region is a single contiguous
+// anonymous mapping, so an access that crosses from one region into the
+// next is still host-backed. The host only commits pages once they are
+// written, so large, mostly unused regions cost almost nothing.
+class HostMemory {
+public:
+  HostMemory() = default;
+  ~HostMemory();
+
+  HostMemory(const HostMemory &) = delete;
+  HostMemory &operator=(const HostMemory &) = delete;
+
+  // Map the given regions, replacing any existing mappings. The contents
+  // of a merged region are preserved if it is mapped again with the same
+  // base and size. Throws an exception if a mapping cannot be created.
+  void map_regions(const std::vector<MemoryRegion> &regions);
+
+  // Return a host pointer to `[addr, addr + size)` if it lies entirely
+  // within one merged region, otherwise nullptr.
+  uint8_t *host_ptr(uint64_t addr, uint64_t size) {
+    if (m_last_hit != nullptr && m_last_hit->contains(addr, size)) {
+      return m_last_hit->data + (addr - m_last_hit->base);
+    }
+    return lookup(addr, size);
+  }
+
+  // Zero `size` bytes at `ptr`, which must have been returned by host_ptr().
+  // Whole pages are handed back to the host rather than written, so zeroing
+  // a large area does not commit memory for it.
+  static void zero(uint8_t *ptr, uint64_t size);
+
+private:
+  struct MappedRegion {
+    uint64_t base = 0;
+    uint64_t size = 0;
+    uint8_t *data = nullptr;
+
+    bool contains(uint64_t addr, uint64_t len) const {
+      return addr >= base && len <= size && addr - base <= size - len;
+    }
+  };
+
+  uint8_t *lookup(uint64_t addr, uint64_t size);
+  void unmap_all();
+
+  std::vector<MappedRegion> m_regions;
+  // Most accesses hit the same region as the previous one.
+  const MappedRegion *m_last_hit = nullptr;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// The events a callbacks_if can handle, one per callback method.
+enum class callback_event : unsigned {
+  pre_step,
+  post_step,
+  fetch,
+  mem_write,
+  mem_read,
+  mem_exception,
+  xreg_full_write,
+  freg_write,
+  csr_full_write,
+  csr_full_read,
+  vreg_write,
+  pc_write,
+  redirect,
+  trap,
+  xret,
+  instret,
+  ptw_start,
+  ptw_step,
+  ptw_success,
+  ptw_fail,
+  tlb_add,
+  tlb_flush_begin,
+  tlb_flush,
+  tlb_flush_end,
+};
+
+constexpr size_t num_callback_events = static_cast<size_t>(callback_event::tlb_flush_end) + 1;
+
+// A set of callback events.
+using callback_event_mask = uint32_t;
+
+static_assert(num_callback_events <= sizeof(callback_event_mask) * 8);
+
+constexpr callback_event_mask all_callback_events = (callback_event_mask{1} << num_callback_events) - 1;
+
+template <typename... Events> constexpr callback_event_mask callback_events(Events... events) {
+  return ((callback_event_mask{1} << static_cast<unsigned>(events)) | ... | callback_event_mask{0});
+}
@@ -129,16 +129,20 @@ void callbacks_if::ptw_fail_callback(
 
 void callbacks_if::tlb_add_callback(
   [[maybe_unused]] ModelImpl &model,
-  [[maybe_unused]] ModelImpl::TLB tlb,
-  [[maybe_unused]] uint64_t index
+  [[maybe_unused]] uint64_t index,
+  [[maybe_unused]] const ModelImpl::TLB_Entry &entry
 ) {
 }
 
 void callbacks_if::tlb_flush_begin_callback([[maybe_unused]] ModelImpl &model) {
 }
 
-void callbacks_if::tlb_flush_callback([[maybe_unused]] ModelImpl &model, [[maybe_unused]] uint64_t index) {
+void callbacks_if::tlb_flush_callback(
+  [[maybe_unused]] ModelImpl &model,
+  [[maybe_unused]] uint64_t index,
+  [[maybe_unused]] const ModelImpl::TLB_Entry &entry
+) {
 }
 
-void callbacks_if::tlb_flush_end_callback([[maybe_unused]] ModelImpl &model, [[maybe_unused]] ModelImpl::TLB tlb) {
+void callbacks_if::tlb_flush_end_callback([[maybe_unused]] ModelImpl &model) {
 }
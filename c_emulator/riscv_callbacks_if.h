@@ -1,5 +1,6 @@
 #pragma once
 
+#include "riscv_callback_events.h"
 #include "riscv_model_impl.h"
 #include "sail.h"
 
@@ -7,6 +8,14 @@ class callbacks_if {
 public:
   virtual ~callbacks_if() = default;
 
+  // The events this object handles. Only the methods for these events are
+  // called, so events that no registered callback handles cost nothing.
+  // This is read once, when the callback is registered. Overrides should
+  // be, or be checked against, overridden_callback_events() below.
+  virtual callback_event_mask subscribed_events() const {
+    return all_callback_events;
+  }
+
   // Callback invoked before each step
   virtual void pre_step_callback(ModelImpl &model, bool is_waiting);
 
@@ -55,11 +64,56 @@ public:
 
   virtual void ptw_fail_callback(ModelImpl &model, ModelImpl::PTW_Error error_type, int64_t level, sbits pte_addr);
 
-  virtual void tlb_add_callback(ModelImpl &model, ModelImpl::TLB tlb, uint64_t index);
+  virtual void tlb_add_callback(ModelImpl &model, uint64_t index, const ModelImpl::TLB_Entry &entry);
 
   virtual void tlb_flush_begin_callback(ModelImpl &model);
 
-  virtual void tlb_flush_callback(ModelImpl &model, uint64_t index);
+  // Called for each entry that a flush removes, with its old contents.
+  virtual void tlb_flush_callback(ModelImpl &model, uint64_t index, const ModelImpl::TLB_Entry &entry);
 
-  virtual void tlb_flush_end_callback(ModelImpl &model, ModelImpl::TLB tlb);
+  virtual void tlb_flush_end_callback(ModelImpl &model);
 };
+
+namespace callbacks_detail {
+
+// `&Callbacks::f` points to a member of callbacks_if unless Callbacks (or a
+// class between them) overrides f.
+template <typename... Args>
+constexpr callback_event_mask overridden_event(void (callbacks_if::*)(Args...), callback_event) {
+  return 0;
+}
+template <typename Method> constexpr callback_event_mask overridden_event(Method, callback_event event) {
+  return callback_events(event);
+}
+
+} // namespace callbacks_detail
+
+// The events whose methods `Callbacks` overrides, so that a subscription
+// can't go out of date when a method is added or removed.
+template <typename Callbacks> constexpr callback_event_mask overridden_callback_events() {
+  using callbacks_detail::overridden_event;
+  return overridden_event(&Callbacks::pre_step_callback, callback_event::pre_step)
+    | overridden_event(&Callbacks::post_step_callback, callback_event::post_step)
+    | overridden_event(&Callbacks::fetch_callback, callback_event::fetch)
+    | overridden_event(&Callbacks::mem_write_callback, callback_event::mem_write)
+    | overridden_event(&Callbacks::mem_read_callback, callback_event::mem_read)
+    | overridden_event(&Callbacks::mem_exception_callback, callback_event::mem_exception)
+    | overridden_event(&Callbacks::xreg_full_write_callback, callback_event::xreg_full_write)
+    | overridden_event(&Callbacks::freg_write_callback, callback_event::freg_write)
+    | overridden_event(&Callbacks::csr_full_write_callback, callback_event::csr_full_write)
+    | overridden_event(&Callbacks::csr_full_read_callback, callback_event::csr_full_read)
+    | overridden_event(&Callbacks::vreg_write_callback, callback_event::vreg_write)
+    | overridden_event(&Callbacks::pc_write_callback, callback_event::pc_write)
+    | overridden_event(&Callbacks::redirect_callback, callback_event::redirect)
+    | overridden_event(&Callbacks::trap_callback, callback_event::trap)
+    | overridden_event(&Callbacks::xret_callback, callback_event::xret)
+    | overridden_event(&Callbacks::instret_callback, callback_event::instret)
+    | overridden_event(&Callbacks::ptw_start_callback, callback_event::ptw_start)
+    | overridden_event(&Callbacks::ptw_step_callback, callback_event::ptw_step)
+    | overridden_event(&Callbacks::ptw_success_callback, callback_event::ptw_success)
+    | overridden_event(&Callbacks::ptw_fail_callback, callback_event::ptw_fail)
+    | overridden_event(&Callbacks::tlb_add_callback, callback_event::tlb_add)
+    | overridden_event(&Callbacks::tlb_flush_begin_callback, callback_event::tlb_flush_begin)
+    | overridden_event(&Callbacks::tlb_flush_callback, callback_event::tlb_flush)
+    | overridden_event(&Callbacks::tlb_flush_end_callback, callback_event::tlb_flush_end);
+}
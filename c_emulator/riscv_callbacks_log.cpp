@@ -13,7 +13,7 @@ log_callbacks::log_callbacks(
   bool config_print_ptw,
   bool config_print_tlb,
   bool config_use_abi_names,
-  FILE *trace_log
+  TraceSink *trace
 ) :
     config_print_gpr(config_print_gpr),
     config_print_fpr(config_print_fpr),
@@ -23,92 +23,122 @@ log_callbacks::log_callbacks(
     config_use_abi_names(config_use_abi_names),
     config_print_ptw(config_print_ptw),
     config_print_tlb(config_print_tlb),
-    trace_log(trace_log) {
+    trace(trace) {
+}
+
+namespace {
+
+// The events that each trace option needs.
+constexpr callback_event_mask mem_access_events = callback_events(callback_event::mem_write, callback_event::mem_read);
+constexpr callback_event_mask gpr_events = callback_events(callback_event::xreg_full_write);
+constexpr callback_event_mask fpr_events = callback_events(callback_event::freg_write);
+constexpr callback_event_mask csr_events =
+  callback_events(callback_event::csr_full_write, callback_event::csr_full_read);
+constexpr callback_event_mask vreg_events = callback_events(callback_event::vreg_write);
+constexpr callback_event_mask ptw_events = callback_events(
+  callback_event::ptw_start,
+  callback_event::ptw_step,
+  callback_event::ptw_success,
+  callback_event::ptw_fail
+);
+constexpr callback_event_mask tlb_events = callback_events(
+  callback_event::tlb_add,
+  callback_event::tlb_flush_begin,
+  callback_event::tlb_flush,
+  callback_event::tlb_flush_end
+);
+
+// Every method that log_callbacks overrides is reachable from a trace
+// option, and every trace option only needs methods that it overrides.
+static_assert(
+  (mem_access_events | gpr_events | fpr_events | csr_events | vreg_events | ptw_events | tlb_events) ==
+    overridden_callback_events<log_callbacks>(),
+  "log_callbacks::subscribed_events() is out of date"
+);
+
+} // namespace
+
+// Only subscribe to the events that are traced, so that the callbacks cost
+// nothing when tracing is off.
+callback_event_mask log_callbacks::subscribed_events() const {
+  callback_event_mask events = 0;
+  if (trace == nullptr) {
+    return events;
+  }
+  if (config_print_mem_access) {
+    events |= mem_access_events;
+  }
+  if (config_print_gpr) {
+    events |= gpr_events;
+  }
+  if (config_print_fpr) {
+    events |= fpr_events;
+  }
+  if (config_print_csr) {
+    events |= csr_events;
+  }
+  if (config_print_vreg) {
+    events |= vreg_events;
+  }
+  if (config_print_ptw) {
+    events |= ptw_events;
+  }
+  if (config_print_tlb) {
+    events |= tlb_events;
+  }
+  return events;
+}
+
+// Convert `value` to little-endian bytes, zero extended to its full width.
+// The result is valid until the next call.
+const uint8_t *log_callbacks::lbits_bytes(lbits value) {
+  const size_t size = std::max<size_t>((value.len + 7) / 8, mpz_sizeinbase(*value.bits, 256));
+  value_bytes.assign(size, 0);
+  mpz_export(value_bytes.data(), nullptr, -1, 1, 0, 0, *value.bits);
+  return value_bytes.data();
 }
 
 // Implementations of default callbacks for trace printing.
 // The model assumes that these functions do not change the state of the model.
+// They are only called for the events in subscribed_events(), so `trace`
+// is set.
 
 void log_callbacks::mem_write_callback(ModelImpl &model, const char *type, sbits paddr, int64_t width, lbits value) {
   // This is just passed due to Sail type system requirements.
   (void)width;
-  if (trace_log != nullptr && config_print_mem_access) {
-    fprintf(
-      trace_log,
-      "mem[%s,0x%0*" PRIX64 "] <- ",
-      type,
-      static_cast<int>((model.physaddrbits_len() + 3) / 4),
-      paddr.bits
-    );
-    gmp_fprintf(trace_log, "0x%0*ZX\n", value.len / 4, *value.bits);
-  }
+  const int paddr_digits = static_cast<int>((model.physaddrbits_len() + 3) / 4);
+  const uint8_t *bytes = lbits_bytes(value);
+  trace->mem_access(type, true, paddr.bits, paddr_digits, bytes, value_bytes.size(), static_cast<int>(value.len / 4));
 }
 
 void log_callbacks::mem_read_callback(ModelImpl &model, const char *type, sbits paddr, int64_t width, lbits value) {
   // This is just passed due to Sail type system requirements.
   (void)width;
-  if (trace_log != nullptr && config_print_mem_access) {
-    fprintf(
-      trace_log,
-      "mem[%s,0x%0*" PRIX64 "] -> ",
-      type,
-      static_cast<int>((model.physaddrbits_len() + 3) / 4),
-      paddr.bits
-    );
-    gmp_fprintf(trace_log, "0x%0*ZX\n", value.len / 4, *value.bits);
-  }
+  const int paddr_digits = static_cast<int>((model.physaddrbits_len() + 3) / 4);
+  const uint8_t *bytes = lbits_bytes(value);
+  trace->mem_access(type, false, paddr.bits, paddr_digits, bytes, value_bytes.size(), static_cast<int>(value.len / 4));
 }
 
 void log_callbacks::xreg_full_write_callback(ModelImpl &, const_sail_string abi_name, sbits reg, sbits value) {
-  if (trace_log != nullptr && config_print_gpr) {
-    if (config_use_abi_names) {
-      fprintf(trace_log, "%s <- 0x%0*" PRIX64 "\n", abi_name, static_cast<int>(value.len / 4), value.bits);
-    } else {
-      fprintf(trace_log, "x%" PRIu64 " <- 0x%0*" PRIX64 "\n", reg.bits, static_cast<int>(value.len / 4), value.bits);
-    }
-  }
+  const char *name = config_use_abi_names ? abi_name : nullptr;
+  trace->xreg_write(name, reg.bits, value.bits, static_cast<int>(value.len / 4));
 }
 
 void log_callbacks::freg_write_callback(ModelImpl &, unsigned reg, sbits value) {
-  // TODO: will only print bits; should we print in floating point format?
-  if (trace_log != nullptr && config_print_fpr) {
-    // TODO: Might need to change from PRIX64 to PRIX128 once the "Q"
-    // extension is supported
-    fprintf(trace_log, "f%d <- 0x%0*" PRIX64 "\n", reg, static_cast<int>(value.len / 4), value.bits);
-  }
+  trace->freg_write(reg, value.bits, static_cast<int>(value.len / 4));
 }
 
 void log_callbacks::csr_full_write_callback(ModelImpl &, const_sail_string csr_name, unsigned reg, sbits value) {
-  if (trace_log != nullptr && config_print_csr) {
-    fprintf(
-      trace_log,
-      "CSR %s (0x%03X) <- 0x%0*" PRIX64 "\n",
-      csr_name,
-      reg,
-      static_cast<int>(value.len / 4),
-      value.bits
-    );
-  }
+  trace->csr_access(csr_name, reg, true, value.bits, static_cast<int>(value.len / 4));
 }
 
 void log_callbacks::csr_full_read_callback(ModelImpl &, const_sail_string csr_name, unsigned reg, sbits value) {
-  if (trace_log != nullptr && config_print_csr) {
-    fprintf(
-      trace_log,
-      "CSR %s (0x%03X) -> 0x%0*" PRIX64 "\n",
-      csr_name,
-      reg,
-      static_cast<int>(value.len / 4),
-      value.bits
-    );
-  }
+  trace->csr_access(csr_name, reg, false, value.bits, static_cast<int>(value.len / 4));
 }
 
 void log_callbacks::vreg_write_callback(ModelImpl &, unsigned reg, lbits value) {
-  if (trace_log != nullptr && config_print_vreg) {
-    fprintf(trace_log, "v%d <- ", reg);
-    gmp_fprintf(trace_log, "0x%0*ZX\n", value.len / 4, *value.bits);
-  }
+  const uint8_t *bytes = lbits_bytes(value);
+  trace->vreg_write(reg, bytes, value_bytes.size(), static_cast<int>(value.len / 4));
 }
 
 // Page table walk callback
@@ -118,33 +148,17 @@ void log_callbacks::ptw_start_callback(
   ModelImpl::MemoryAccessType access_type,
   ModelImpl::Privilege privilege
 ) {
-  if (trace_log != nullptr && config_print_ptw) {
-    fprintf(
-      trace_log,
-      "PTW: Start, vpn=0x%" PRIx64 ", access_type=%s, privilege=%s\n",
-      vpn,
-      model.memory_access_type_to_string(access_type).c_str(),
-      model.privilege_to_string(privilege).c_str()
-    );
-  }
+  const std::string access_type_str = model.memory_access_type_to_string(access_type);
+  const std::string privilege_str = model.privilege_to_string(privilege);
+  trace->ptw_start(vpn, access_type_str.c_str(), privilege_str.c_str());
 }
 
 void log_callbacks::ptw_step_callback(ModelImpl & /*model*/, int64_t level, sbits pte_addr, uint64_t pte) {
-  if (trace_log != nullptr && config_print_ptw) {
-    fprintf(
-      trace_log,
-      "PTW: Step, level=%" PRId64 ", pte=0x%" PRIX64 ", pte_addr=0x%" PRIX64 "\n",
-      level,
-      pte,
-      pte_addr.bits
-    );
-  }
+  trace->ptw_step(level, pte, pte_addr.bits);
 }
 
 void log_callbacks::ptw_success_callback(ModelImpl & /*model*/, uint64_t final_ppn, int64_t level) {
-  if (trace_log != nullptr && config_print_ptw) {
-    fprintf(trace_log, "PTW: Success, final_ppn=0x%" PRIx64 ", level=%" PRId64 "\n", final_ppn, level);
-  }
+  trace->ptw_success(final_ppn, level);
 }
 
 void log_callbacks::ptw_fail_callback(
@@ -153,95 +167,38 @@ void log_callbacks::ptw_fail_callback(
   int64_t level,
   sbits pte_addr
 ) {
-  if (trace_log != nullptr && config_print_ptw) {
-    fprintf(
-      trace_log,
-      "PTW: failed, error=%s, level=%" PRId64 ", pte_addr=0x%" PRIX64 "\n",
-      model.ptw_error_to_string(error_type).c_str(),
-      level,
-      pte_addr.bits
-    );
-  }
+  const std::string error = model.ptw_error_to_string(error_type);
+  trace->ptw_fail(error.c_str(), level, pte_addr.bits);
 }
 
-namespace {
-
-void print_tlb(FILE *trace_log, ModelImpl &, ModelImpl::TLB tlb, const std::vector<uint64_t> &indices, bool is_flush) {
-  fprintf(
-    trace_log,
-    "TLB %s [ len=%zu ]\n"
-    "╔═════╦════╦══════════╦══════════════════════╦══════════════════════╦══════════════════════╦══════════════════════"
-    "╦══════════════════════"
-    "╗\n"
-    "║ IDX ║ GL ║   ASID   ║         VPN          ║         PTE          ║     LEVEL_MASK       ║         PPN          "
-    "║       PTE_ADDR       "
-    "║\n"
-    "╠═════╬════╬══════════╬══════════════════════╬══════════════════════╬══════════════════════╬══════════════════════"
-    "╬══════════════════════"
-    "╣\n",
-    is_flush ? "flush" : "add",
-    tlb.len
-  );
-  for (size_t i = 0; i < tlb.len; i++) {
-    bool is_entry_selected = std::find(indices.begin(), indices.end(), i) != indices.end();
-    const char *annotation = is_entry_selected ? (is_flush ? "  <- flushed" : "  <- added") : "";
-
-    const auto &entry = tlb.data[i];
-    if (entry.kind == hart::Kind_zSomezIRTLB_EntryzK) {
-      const auto &e = entry.variants.zSomezIRTLB_EntryzK;
-      fprintf(
-        trace_log,
-        "║ %3zu ║  %c ║ 0x%06" PRIX64 " ║ 0x%018" PRIX64 " ║ 0x%018" PRIX64 " ║ 0x%018" PRIX64 " ║ 0x%018" PRIX64
-        " ║ 0x%018" PRIX64 " ║%s\n",
-        i,
-        e.zglobal ? 'Y' : 'N',
-        e.zasid.bits,
-        e.zvpn,
-        e.zpte,
-        e.zlevelMask,
-        e.zppn,
-        e.zpteAddr.bits,
-        annotation
-      );
-    } else {
-      fprintf(
-        trace_log,
-        "║ %3zu ║  - ║   ----   ║         ----         ║         ----         ║         ----         ║         ----    "
-        "     ║         ----    "
-        "     ║%s\n",
-        i,
-        annotation
-      );
-    }
-  }
-  fprintf(
-    trace_log,
-    "╚═════╩════╩══════════╩══════════════════════╩══════════════════════╩══════════════════════╩══════════════════════"
-    "╩══════════════════════"
-    "╝\n"
-  );
+TraceTlbEntry log_callbacks::trace_tlb_entry(uint64_t index, const ModelImpl::TLB_Entry &entry) {
+  TraceTlbEntry out;
+  out.index = index;
+  out.global = entry.zglobal;
+  out.asid = entry.zasid.bits;
+  out.vpn = entry.zvpn;
+  out.pte = entry.zpte;
+  out.level_mask = entry.zlevelMask;
+  out.ppn = entry.zppn;
+  out.pte_addr = entry.zpteAddr.bits;
+  return out;
 }
 
-} // namespace
-
-void log_callbacks::tlb_add_callback(ModelImpl &model, ModelImpl::TLB tlb, uint64_t index) {
-  if (trace_log != nullptr && config_print_tlb) {
-    print_tlb(trace_log, model, tlb, {index}, false);
-  }
+void log_callbacks::tlb_add_callback(ModelImpl &, uint64_t index, const ModelImpl::TLB_Entry &entry) {
+  tlb_entries.assign(1, trace_tlb_entry(index, entry));
+  trace->tlb(tlb_entries, false);
 }
 
 void log_callbacks::tlb_flush_begin_callback(ModelImpl &) {
-  pending_flush_indices.clear();
+  tlb_entries.clear();
 }
 
-void log_callbacks::tlb_flush_callback(ModelImpl &, uint64_t index) {
-  if (config_print_tlb) {
-    pending_flush_indices.push_back(index);
-  }
+void log_callbacks::tlb_flush_callback(ModelImpl &, uint64_t index, const ModelImpl::TLB_Entry &entry) {
+  tlb_entries.push_back(trace_tlb_entry(index, entry));
 }
 
-void log_callbacks::tlb_flush_end_callback(ModelImpl &model, ModelImpl::TLB tlb) {
-  if (trace_log != nullptr && config_print_tlb && !pending_flush_indices.empty()) {
-    print_tlb(trace_log, model, tlb, pending_flush_indices, true);
+void log_callbacks::tlb_flush_end_callback(ModelImpl &) {
+  if (!tlb_entries.empty()) {
+    trace->tlb(tlb_entries, true);
   }
 }
@@ -1,6 +1,7 @@
 #pragma once
 #include "riscv_callbacks_if.h"
 #include "sail.h"
+#include "trace_format.h"
 
 class log_callbacks : public callbacks_if {
 
@@ -15,10 +16,12 @@ public:
     bool config_print_tlb = true,
     bool config_use_abi_names = false,
 
-    FILE *trace_log = nullptr
+    // Nothing is traced if this is null.
+    TraceSink *trace = nullptr
   );
 
   // callbacks_if
+  callback_event_mask subscribed_events() const override;
   void mem_write_callback(ModelImpl &model, const char *type, sbits paddr, int64_t width, lbits value) override;
   void mem_read_callback(ModelImpl &model, const char *type, sbits paddr, int64_t width, lbits value) override;
   void xreg_full_write_callback(ModelImpl &model, const_sail_string abi_name, sbits reg, sbits value) override;
@@ -36,12 +39,15 @@ public:
   void ptw_step_callback(ModelImpl &model, int64_t level, sbits pte_addr, uint64_t pte) override;
   void ptw_success_callback(ModelImpl &model, uint64_t final_ppn, int64_t level) override;
   void ptw_fail_callback(ModelImpl &model, ModelImpl::PTW_Error error_type, int64_t level, sbits pte_addr) override;
-  void tlb_add_callback(ModelImpl &model, ModelImpl::TLB tlb, uint64_t index) override;
+  void tlb_add_callback(ModelImpl &model, uint64_t index, const ModelImpl::TLB_Entry &entry) override;
   void tlb_flush_begin_callback(ModelImpl &model) override;
-  void tlb_flush_callback(ModelImpl &model, uint64_t index) override;
-  void tlb_flush_end_callback(ModelImpl &model, ModelImpl::TLB tlb) override;
+  void tlb_flush_callback(ModelImpl &model, uint64_t index, const ModelImpl::TLB_Entry &entry) override;
+  void tlb_flush_end_callback(ModelImpl &model) override;
 
 private:
+  static TraceTlbEntry trace_tlb_entry(uint64_t index, const ModelImpl::TLB_Entry &entry);
+  const uint8_t *lbits_bytes(lbits value);
+
   bool config_print_gpr;
   bool config_print_fpr;
   bool config_print_vreg;
@@ -50,6 +56,8 @@ private:
   bool config_use_abi_names;
   bool config_print_ptw;
   bool config_print_tlb;
-  FILE *trace_log;
-  std::vector<uint64_t> pending_flush_indices;
+  TraceSink *trace;
+  std::vector<uint8_t> value_bytes;
+  // The entries flushed since tlb_flush_begin_callback().
+  std::vector<TraceTlbEntry> tlb_entries;
 };
@@ -0,0 +1,210 @@
+#include "riscv_callbacks_profile.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <set>
+
+namespace {
+
+// How a jump changes the call stack, following the return-address stack
+// hints of the unprivileged specification.
+struct StackEffect {
+  bool pop = false;
+  bool push = false;
+};
+
+bool is_link_register(unsigned reg) {
+  return reg == 1 || reg == 5;
+}
+
+StackEffect jalr_effect(unsigned rd, unsigned rs1) {
+  const bool rd_link = is_link_register(rd);
+  const bool rs1_link = is_link_register(rs1);
+  return {
+    .pop = rs1_link && (!rd_link || rd != rs1),
+    .push = rd_link,
+  };
+}
+
+StackEffect stack_effect(uint32_t opcode, bool rv32) {
+  if ((opcode & 0b11) == 0b11) {
+    const unsigned rd = (opcode >> 7) & 0x1f;
+    const unsigned rs1 = (opcode >> 15) & 0x1f;
+    switch (opcode & 0x7f) {
+    case 0b1101111: // jal
+      return {.pop = false, .push = is_link_register(rd)};
+    case 0b1100111: // jalr
+      if (((opcode >> 12) & 0b111) == 0) {
+        return jalr_effect(rd, rs1);
+      }
+      return {};
+    default:
+      return {};
+    }
+  }
+  const unsigned quadrant = opcode & 0b11;
+  const unsigned funct3 = (opcode >> 13) & 0b111;
+  // c.jal, which is c.addiw on RV64.
+  if (rv32 && quadrant == 0b01 && funct3 == 0b001) {
+    return {.pop = false, .push = true};
+  }
+  // c.jr and c.jalr.
+  const unsigned rs1 = (opcode >> 7) & 0x1f;
+  const unsigned rs2 = (opcode >> 2) & 0x1f;
+  if (quadrant == 0b10 && funct3 == 0b100 && rs2 == 0 && rs1 != 0) {
+    const bool link = ((opcode >> 12) & 1) != 0;
+    return jalr_effect(link ? 1 : 0, rs1);
+  }
+  return {};
+}
+
+double percent(uint64_t part, uint64_t total) {
+  return total == 0 ? 0.0 : 100.0 * static_cast<double>(part) / static_cast<double>(total);
+}
+
+} // namespace
+
+profile_callbacks::profile_callbacks(ModelImpl &model, uint64_t interval)
+    : m_symbols(model.elf_symbols()), m_rv32(model.xlen() == 32), m_interval(interval) {
+}
+
+profile_callbacks::hart_profile &profile_callbacks::profile_for(const ModelImpl &model) {
+  const uint64_t index = model.hart_index();
+  while (m_harts.size() <= index) {
+    m_harts.emplace_back(m_interval);
+  }
+  return m_harts[index];
+}
+
+void profile_callbacks::fetch_callback(ModelImpl &model, sbits opcode) {
+  hart_profile &profile = profile_for(model);
+  profile.pc = model.pc();
+  profile.opcode = static_cast<uint32_t>(opcode.bits);
+}
+
+void profile_callbacks::instret_callback(ModelImpl &model) {
+  hart_profile &profile = profile_for(model);
+  // The instruction is sampled in its caller's stack, before any call or
+  // return that it makes.
+  if (--profile.insns_until_sample == 0) {
+    profile.insns_until_sample = m_interval;
+    sample(profile);
+  }
+
+  const StackEffect effect = stack_effect(profile.opcode, m_rv32);
+  // Don't return past the frame of a trap that is being handled.
+  const size_t floor = profile.trap_depths.empty() ? 0 : profile.trap_depths.back() + 1;
+  if (effect.pop && profile.call_stack.size() > floor) {
+    profile.call_stack.pop_back();
+  }
+  if (effect.push) {
+    if (profile.call_stack.size() == max_stack_depth) {
+      profile.call_stack.pop_front();
+      for (size_t &depth : profile.trap_depths) {
+        if (depth > 0) {
+          depth--;
+        }
+      }
+    }
+    profile.call_stack.push_back(profile.pc);
+  }
+}
+
+void profile_callbacks::trap_callback(ModelImpl &model, bool, fbits) {
+  hart_profile &profile = profile_for(model);
+  // The handler runs as if called from the trapped instruction.
+  profile.trap_depths.push_back(profile.call_stack.size());
+  profile.call_stack.push_back(model.pc());
+}
+
+void profile_callbacks::xret_callback(ModelImpl &model, bool) {
+  hart_profile &profile = profile_for(model);
+  if (!profile.trap_depths.empty()) {
+    profile.call_stack.resize(std::min(profile.call_stack.size(), profile.trap_depths.back()));
+    profile.trap_depths.pop_back();
+  }
+}
+
+std::string profile_callbacks::function_name(const Symbol *function) {
+  return function == nullptr ? "[unknown]" : function->name;
+}
+
+void profile_callbacks::sample(hart_profile &profile) {
+  std::vector<const Symbol *> stack;
+  stack.reserve(profile.call_stack.size() + 1);
+  for (uint64_t pc : profile.call_stack) {
+    stack.push_back(m_symbols.lookup(pc));
+  }
+  stack.push_back(m_symbols.lookup(profile.pc));
+  profile.samples[stack]++;
+  m_total_samples++;
+}
+
+bool profile_callbacks::write(const std::string &path) const {
+  // Samples in each function, and in each function or its callees.
+  std::map<const Symbol *, uint64_t> self;
+  std::map<const Symbol *, uint64_t> total;
+  for (const hart_profile &profile : m_harts) {
+    for (const auto &[stack, count] : profile.samples) {
+      self[stack.back()] += count;
+      // Recursive functions are only counted once per sample.
+      for (const Symbol *function : std::set<const Symbol *>(stack.begin(), stack.end())) {
+        total[function] += count;
+      }
+    }
+  }
+  std::vector<std::pair<const Symbol *, uint64_t>> by_total(total.begin(), total.end());
+  std::stable_sort(by_total.begin(), by_total.end(), [&self](const auto &a, const auto &b) {
+    return self[a.first] != self[b.first] ? self[a.first] > self[b.first] : a.second > b.second;
+  });
+
+  FILE *flat = fopen(path.c_str(), "w");
+  if (flat == nullptr) {
+    return false;
+  }
+  fprintf(
+    flat,
+    "# %" PRIu64 " samples, one every %" PRIu64 " retired instructions.\n"
+    "#  self%%       self  total%%      total  function\n",
+    m_total_samples,
+    m_interval
+  );
+  for (const auto &[function, count] : by_total) {
+    fprintf(
+      flat,
+      "%7.2f %10" PRIu64 " %7.2f %10" PRIu64 "  %s\n",
+      percent(self[function], m_total_samples),
+      self[function],
+      percent(count, m_total_samples),
+      count,
+      function_name(function).c_str()
+    );
+  }
+  const bool flat_ok = ferror(flat) == 0;
+  fclose(flat);
+
+  FILE *folded = fopen((path + ".folded").c_str(), "w");
+  if (folded == nullptr) {
+    return false;
+  }
+  for (size_t index = 0; index < m_harts.size(); index++) {
+    for (const auto &[stack, count] : m_harts[index].samples) {
+      std::string line;
+      if (m_harts.size() > 1) {
+        line = "hart" + std::to_string(index);
+      }
+      for (const Symbol *function : stack) {
+        if (!line.empty()) {
+          line += ';';
+        }
+        line += function_name(function);
+      }
+      fprintf(folded, "%s %" PRIu64 "\n", line.c_str(), count);
+    }
+  }
+  const bool folded_ok = ferror(folded) == 0;
+  fclose(folded);
+
+  return flat_ok && folded_ok;
+}
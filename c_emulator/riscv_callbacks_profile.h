@@ -0,0 +1,81 @@
+#pragma once
+
+#include "riscv_callbacks_if.h"
+#include "sail.h"
+#include "symbol_table.h"
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+// A PC-sampling profiler. Every `interval` retired instructions it records
+// the function of the retired instruction and the call stack that led to
+// it. The call stack is tracked from the jumps that the calling convention
+// marks as calls and returns (jal and jalr that link through or return
+// via ra or t0), and from traps and xRETs, so it needs no frame pointers.
+//
+// It can be registered on several harts, each of which is sampled and has
+// its call stack tracked separately.
+class profile_callbacks : public callbacks_if {
+public:
+  // Functions are named from the ELF symbols of `model`, which the harts
+  // share.
+  profile_callbacks(ModelImpl &model, uint64_t interval);
+
+  callback_event_mask subscribed_events() const override {
+    return overridden_callback_events<profile_callbacks>();
+  }
+  void fetch_callback(ModelImpl &model, sbits opcode) override;
+  void instret_callback(ModelImpl &model) override;
+  void trap_callback(ModelImpl &model, bool is_interrupt, fbits cause) override;
+  void xret_callback(ModelImpl &model, bool is_mret) override;
+
+  // Write the flat profile of all the harts to `path`, and the folded
+  // stacks (one line of `outer;...;inner count` per distinct stack, as read
+  // by flamegraph.pl and similar tools) to `path.folded`. If more than one
+  // hart was sampled, each folded stack starts with a `hart<n>` frame.
+  // Returns false if either file can't be written.
+  bool write(const std::string &path) const;
+
+private:
+  // Stacks deeper than this lose their outermost frames, e.g. if code
+  // that doesn't return normally keeps calling.
+  static constexpr size_t max_stack_depth = 1024;
+
+  // Functions are identified by their symbols, or nullptr if the address
+  // has no symbol.
+  static std::string function_name(const Symbol *function);
+
+  struct hart_profile {
+    explicit hart_profile(uint64_t interval) : insns_until_sample(interval) {
+    }
+
+    uint64_t insns_until_sample;
+
+    // The last fetched instruction, which is the one that retires next.
+    uint64_t pc = 0;
+    uint32_t opcode = 0;
+
+    // The PCs of the calls and trapped instructions on the call stack,
+    // outermost first, and the depth of the stack at each trap that is
+    // being handled. The outermost frames are dropped at the maximum depth.
+    std::deque<uint64_t> call_stack;
+    std::vector<size_t> trap_depths;
+
+    // The number of samples of each stack of functions, outermost first.
+    std::map<std::vector<const Symbol *>, uint64_t> samples;
+  };
+
+  hart_profile &profile_for(const ModelImpl &model);
+  void sample(hart_profile &profile);
+
+  SymbolTable &m_symbols;
+  const bool m_rv32;
+  const uint64_t m_interval;
+
+  // Indexed by hart, and grown as harts are seen.
+  std::vector<hart_profile> m_harts;
+  uint64_t m_total_samples = 0;
+};
@@ -6,6 +6,9 @@ class rvfi_callbacks : public callbacks_if {
 
 public:
   // callbacks_if
+  callback_event_mask subscribed_events() const override {
+    return overridden_callback_events<rvfi_callbacks>();
+  }
   void mem_write_callback(ModelImpl &model, const char *type, sbits paddr, int64_t width, lbits value) override;
   void mem_read_callback(ModelImpl &model, const char *type, sbits paddr, int64_t width, lbits value) override;
   void mem_exception_callback(ModelImpl &model, sbits paddr, uint64_t num_of_exception) override;
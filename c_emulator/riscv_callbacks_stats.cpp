@@ -0,0 +1,124 @@
+#include "riscv_callbacks_stats.h"
+
+#include "jsoncons/json.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+namespace {
+
+// `counts` as a JSON object, largest first.
+jsoncons::ojson sorted_counts(const std::map<std::string, uint64_t> &counts) {
+  std::vector<std::pair<std::string, uint64_t>> sorted(counts.begin(), counts.end());
+  std::stable_sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) { return a.second > b.second; });
+  jsoncons::ojson json(jsoncons::json_object_arg);
+  for (const auto &[key, count] : sorted) {
+    json.insert_or_assign(key, count);
+  }
+  return json;
+}
+
+jsoncons::ojson cause_counts(const std::map<uint64_t, uint64_t> &counts) {
+  jsoncons::ojson json(jsoncons::json_object_arg);
+  for (const auto &[cause, count] : counts) {
+    json.insert_or_assign(std::to_string(cause), count);
+  }
+  return json;
+}
+
+} // namespace
+
+void stats_callbacks::fetch_callback(ModelImpl &model, sbits opcode) {
+  m_kind = kind_of_opcode(model, static_cast<uint32_t>(opcode.bits), opcode.len == 16);
+  m_privilege = model.privilege_index();
+}
+
+void stats_callbacks::instret_callback(ModelImpl &model) {
+  m_kind_counts[m_kind]++;
+  if (m_privilege_counts[m_privilege]++ == 0) {
+    m_privilege_names[m_privilege] = model.privilege_index_to_string(m_privilege);
+  }
+  m_retired++;
+}
+
+void stats_callbacks::trap_callback(ModelImpl &, bool is_interrupt, fbits cause) {
+  (is_interrupt ? m_interrupt_counts : m_exception_counts)[cause]++;
+}
+
+uint32_t stats_callbacks::context_id(ModelImpl &model) {
+  if (m_contexts.size() <= model.hart_index()) {
+    m_contexts.resize(model.hart_index() + 1);
+  }
+  hart_context &context = m_contexts[model.hart_index()];
+  const uint64_t generation = model.decode_context_generation();
+  if (!context.valid || context.generation != generation) {
+    const auto [it, inserted] =
+      m_context_ids.try_emplace(model.decode_context_to_string(), static_cast<uint32_t>(m_context_ids.size()));
+    context = {true, generation, it->second};
+  }
+  return context.id;
+}
+
+uint32_t stats_callbacks::kind_of_opcode(ModelImpl &model, uint32_t opcode, bool compressed) {
+  // Compressed opcodes can't be confused with others, because the low
+  // two bits of a 32-bit opcode are always 0b11.
+  const uint64_t key = (static_cast<uint64_t>(context_id(model)) << 32) | opcode;
+  const auto it = m_kind_of_opcode.find(key);
+  if (it != m_kind_of_opcode.end()) {
+    return it->second;
+  }
+
+  const std::string assembly = model.opcode_to_string(opcode, compressed);
+  std::string mnemonic = assembly.substr(0, assembly.find(' '));
+  std::string extension = model.opcode_extension_to_string(opcode, compressed);
+  const auto [kind, inserted] = m_kind_of_name.try_emplace(std::make_pair(mnemonic, extension),
+                                                           static_cast<uint32_t>(m_mnemonics.size()));
+  if (inserted) {
+    m_mnemonics.push_back(std::move(mnemonic));
+    m_extensions.push_back(std::move(extension));
+    m_kind_counts.push_back(0);
+  }
+  m_kind_of_opcode.emplace(key, kind->second);
+  return kind->second;
+}
+
+bool stats_callbacks::write(const std::string &path) const {
+  std::map<std::string, uint64_t> mnemonic_counts;
+  std::map<std::string, uint64_t> extension_counts;
+  for (size_t kind = 0; kind < m_mnemonics.size(); kind++) {
+    mnemonic_counts[m_mnemonics[kind]] += m_kind_counts[kind];
+    extension_counts[m_extensions[kind]] += m_kind_counts[kind];
+  }
+  std::map<std::string, uint64_t> privilege_counts;
+  for (size_t privilege = 0; privilege < num_privileges; privilege++) {
+    if (m_privilege_counts[privilege] != 0) {
+      privilege_counts[m_privilege_names[privilege]] = m_privilege_counts[privilege];
+    }
+  }
+  uint64_t traps = 0;
+  for (const auto &[cause, count] : m_exception_counts) {
+    traps += count;
+  }
+  for (const auto &[cause, count] : m_interrupt_counts) {
+    traps += count;
+  }
+
+  jsoncons::ojson stats(jsoncons::json_object_arg);
+  stats.insert_or_assign("retired_instructions", m_retired);
+  stats.insert_or_assign("mnemonics", sorted_counts(mnemonic_counts));
+  stats.insert_or_assign("extensions", sorted_counts(extension_counts));
+  stats.insert_or_assign("privilege_modes", sorted_counts(privilege_counts));
+  stats.insert_or_assign("exceptions", cause_counts(m_exception_counts));
+  stats.insert_or_assign("interrupts", cause_counts(m_interrupt_counts));
+  stats.insert_or_assign("traps", traps);
+  if (traps != 0) {
+    stats.insert_or_assign("instructions_per_trap", static_cast<double>(m_retired) / static_cast<double>(traps));
+  } else {
+    stats.insert_or_assign("instructions_per_trap", jsoncons::ojson::null());
+  }
+
+  std::ofstream out(path);
+  stats.dump_pretty(out);
+  out << '\n';
+  return out.good();
+}
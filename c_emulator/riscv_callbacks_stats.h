@@ -0,0 +1,70 @@
+#pragma once
+
+#include "riscv_callbacks_if.h"
+#include "sail.h"
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Counts retired instructions by mnemonic, extension and privilege, and
+// traps by cause, for `--stats-json`. Each distinct opcode is decoded to
+// its mnemonic and extension once in each decode context (see
+// decode_cache.sail); after that, counting an instruction is a hash lookup
+// of its opcode and an increment. One object can be registered on every
+// hart, to count them all together.
+class stats_callbacks : public callbacks_if {
+public:
+  callback_event_mask subscribed_events() const override {
+    return overridden_callback_events<stats_callbacks>();
+  }
+  void fetch_callback(ModelImpl &model, sbits opcode) override;
+  void instret_callback(ModelImpl &model) override;
+  void trap_callback(ModelImpl &model, bool is_interrupt, fbits cause) override;
+
+  // Write the statistics to `path` as JSON. Returns false if it can't be
+  // written.
+  bool write(const std::string &path) const;
+
+private:
+  // The number of values of the model's Privilege enum.
+  static constexpr size_t num_privileges = 5;
+
+  // The decode context of a hart, as a small number.
+  struct hart_context {
+    bool valid = false;
+    uint64_t generation = 0;
+    uint32_t id = 0;
+  };
+
+  uint32_t context_id(ModelImpl &model);
+  uint32_t kind_of_opcode(ModelImpl &model, uint32_t opcode, bool compressed);
+
+  // The kind of the last fetched instruction, which is the one that
+  // retires next, and the privilege it was fetched in.
+  uint32_t m_kind = 0;
+  uint64_t m_privilege = 0;
+
+  // Indexed by hart.
+  std::vector<hart_context> m_contexts;
+  std::unordered_map<std::string, uint32_t> m_context_ids;
+
+  // Instructions are counted by kind, which is an index into the
+  // mnemonics, extensions and counts below. Opcodes are looked up
+  // together with their context id, in the upper 32 bits.
+  std::unordered_map<uint64_t, uint32_t> m_kind_of_opcode;
+  std::map<std::pair<std::string, std::string>, uint32_t> m_kind_of_name;
+  std::vector<std::string> m_mnemonics;
+  std::vector<std::string> m_extensions;
+  std::vector<uint64_t> m_kind_counts;
+
+  uint64_t m_retired = 0;
+  std::array<uint64_t, num_privileges> m_privilege_counts = {};
+  std::array<std::string, num_privileges> m_privilege_names = {};
+  std::map<uint64_t, uint64_t> m_exception_counts;
+  std::map<uint64_t, uint64_t> m_interrupt_counts;
+};
@@ -14,9 +14,14 @@ public:
     return m_stop_requested;
   }
 
-  void pc_write_callback(ModelImpl &, sbits new_pc) override {
+  callback_event_mask subscribed_events() const override {
+    return overridden_callback_events<stop_at_pc_callbacks>();
+  }
+
+  void pc_write_callback(ModelImpl &model, sbits new_pc) override {
     if (new_pc.bits == m_pc) {
       m_stop_requested = true;
+      model.request_stop();
     }
   }
 
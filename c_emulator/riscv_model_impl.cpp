@@ -1,31 +1,49 @@
 #include "riscv_model_impl.h"
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <random>
+#include <stdexcept>
 #include <unistd.h>
 
 #include "config_utils.h"
 #include "riscv_callbacks_if.h"
+#include "riscv_softfloat.h"
 #include "symbol_table.h"
+#include "vector_kernels.h"
 
 void ModelImpl::register_callback(std::shared_ptr<callbacks_if> cb) {
-  if (std::find(m_callbacks.begin(), m_callbacks.end(), cb) == m_callbacks.end()) {
-    m_callbacks.push_back(cb);
+  if (std::find(m_callbacks.begin(), m_callbacks.end(), cb) != m_callbacks.end()) {
+    return;
   }
+  const callback_event_mask events = cb->subscribed_events();
+  for (size_t event = 0; event < num_callback_events; ++event) {
+    if ((events >> event) & 1) {
+      m_event_callbacks[event].push_back(cb.get());
+    }
+  }
+  m_callbacks.push_back(std::move(cb));
 }
 
 void ModelImpl::remove_callback(std::shared_ptr<callbacks_if> cb) {
+  for (auto &callbacks : m_event_callbacks) {
+    callbacks.erase(std::remove(callbacks.begin(), callbacks.end(), cb.get()), callbacks.end());
+  }
   m_callbacks.erase(std::remove(m_callbacks.begin(), m_callbacks.end(), cb), m_callbacks.end());
 }
 
+void ModelImpl::request_stop() {
+  m_stop_requested = true;
+}
+
 void ModelImpl::call_pre_step_callbacks(bool is_waiting) {
-  for (auto c : m_callbacks) {
+  for (callbacks_if *c : callbacks_for(callback_event::pre_step)) {
     c->pre_step_callback(*this, is_waiting);
   }
 }
 
 void ModelImpl::call_post_step_callbacks(bool is_waiting) {
-  for (auto c : m_callbacks) {
+  for (callbacks_if *c : callbacks_for(callback_event::post_step)) {
     c->post_step_callback(*this, is_waiting);
   }
 }
@@ -34,6 +52,10 @@ void ModelImpl::set_enable_experimental_extensions(bool en) {
   m_enable_experimental_extensions = en;
 }
 
+void ModelImpl::set_host_vregs(bool on) {
+  m_host_vregs = on;
+}
+
 void ModelImpl::set_reservation_set_size_exp(uint64_t exponent) {
   m_reservation_set_addr_mask = ~((1 << exponent) - 1);
 }
@@ -47,157 +69,163 @@ void ModelImpl::set_reservation_invalidate_on_same_hart_store(bool invalidate_on
 }
 
 unit ModelImpl::fetch_callback(sbits opcode) {
-  for (auto c : m_callbacks) {
+  for (callbacks_if *c : callbacks_for(callback_event::fetch)) {
     c->fetch_callback(*this, opcode);
   }
   return UNIT;
 }
 
 unit ModelImpl::mem_write_callback(const char *type, sbits paddr, int64_t width, lbits value) {
-  for (auto c : m_callbacks) {
+  for (callbacks_if *c : callbacks_for(callback_event::mem_write)) {
     c->mem_write_callback(*this, type, paddr, width, value);
   }
   if (m_reservation_invalidate_on_same_hart_store && match_reservation(paddr)) {
     cancel_reservation(UNIT);
   };
+  cancel_other_reservations(paddr.bits, static_cast<uint64_t>(width));
   return UNIT;
 }
 unit ModelImpl::mem_read_callback(const char *type, sbits paddr, int64_t width, lbits value) {
-  for (auto c : m_callbacks) {
+  for (callbacks_if *c : callbacks_for(callback_event::mem_read)) {
     c->mem_read_callback(*this, type, paddr, width, value);
   }
   return UNIT;
 }
 
 unit ModelImpl::mem_exception_callback(sbits paddr, uint64_t num_of_exception) {
-  for (auto c : m_callbacks) {
+  for (callbacks_if *c : callbacks_for(callback_event::mem_exception)) {
     c->mem_exception_callback(*this, paddr, num_of_exception);
   }
   return UNIT;
 }
 
 unit ModelImpl::xreg_full_write_callback(const_sail_string abi_name, sbits reg, sbits value) {
-  for (auto c : m_callbacks) {
+  for (callbacks_if *c : callbacks_for(callback_event::xreg_full_write)) {
     c->xreg_full_write_callback(*this, abi_name, reg, value);
   }
   return UNIT;
 }
 
 unit ModelImpl::freg_write_callback(unsigned reg, sbits value) {
-  for (auto c : m_callbacks) {
+  for (callbacks_if *c : callbacks_for(callback_event::freg_write)) {
     c->freg_write_callback(*this, reg, value);
   }
   return UNIT;
 }
 
 unit ModelImpl::csr_full_write_callback(const_sail_string csr_name, unsigned reg, sbits value) {
-  for (auto c : m_callbacks) {
+  for (callbacks_if *c : callbacks_for(callback_event::csr_full_write)) {
     c->csr_full_write_callback(*this, csr_name, reg, value);
   }
   return UNIT;
 }
 
 unit ModelImpl::csr_full_read_callback(const_sail_string csr_name, unsigned reg, sbits value) {
-  for (auto c : m_callbacks) {
+  for (callbacks_if *c : callbacks_for(callback_event::csr_full_read)) {
     c->csr_full_read_callback(*this, csr_name, reg, value);
   }
   return UNIT;
 }
 
+bool ModelImpl::csr_callbacks_enabled(unit) {
+  return !callbacks_for(callback_event::csr_full_write).empty() ||
+         !callbacks_for(callback_event::csr_full_read).empty();
+}
+
 unit ModelImpl::vreg_write_callback(unsigned reg, lbits value) {
-  for (auto c : m_callbacks) {
+  for (callbacks_if *c : callbacks_for(callback_event::vreg_write)) {
     c->vreg_write_callback(*this, reg, value);
   }
   return UNIT;
 }
 
 unit ModelImpl::pc_write_callback(sbits new_pc) {
-  for (auto c : m_callbacks) {
+  for (callbacks_if *c : callbacks_for(callback_event::pc_write)) {
     c->pc_write_callback(*this, new_pc);
   }
   return UNIT;
 }
 
 unit ModelImpl::redirect_callback(sbits new_pc) {
-  for (auto c : m_callbacks) {
+  for (callbacks_if *c : callbacks_for(callback_event::redirect)) {
     c->redirect_callback(*this, new_pc);
   }
   return UNIT;
 }
 
 unit ModelImpl::trap_callback(bool is_interrupt, fbits cause) {
-  for (auto c : m_callbacks) {
+  for (callbacks_if *c : callbacks_for(callback_event::trap)) {
     c->trap_callback(*this, is_interrupt, cause);
   }
   return UNIT;
 }
 
 unit ModelImpl::xret_callback(bool is_mret) {
-  for (auto c : m_callbacks) {
+  for (callbacks_if *c : callbacks_for(callback_event::xret)) {
     c->xret_callback(*this, is_mret);
   }
   return UNIT;
 }
 
 unit ModelImpl::instret_callback(unit) {
-  for (auto c : m_callbacks) {
+  for (callbacks_if *c : callbacks_for(callback_event::instret)) {
     c->instret_callback(*this);
   }
   return UNIT;
 }
 
 unit ModelImpl::ptw_start_callback(uint64_t vpn, MemoryAccessType access_type, Privilege privilege) {
-  for (auto c : m_callbacks) {
+  for (callbacks_if *c : callbacks_for(callback_event::ptw_start)) {
     c->ptw_start_callback(*this, vpn, access_type, privilege);
   }
   return UNIT;
 }
 
 unit ModelImpl::ptw_step_callback(int64_t level, sbits pte_addr, uint64_t pte) {
-  for (auto c : m_callbacks) {
+  for (callbacks_if *c : callbacks_for(callback_event::ptw_step)) {
     c->ptw_step_callback(*this, level, pte_addr, pte);
   }
   return UNIT;
 }
 
 unit ModelImpl::ptw_success_callback(uint64_t final_ppn, int64_t level) {
-  for (auto c : m_callbacks) {
+  for (callbacks_if *c : callbacks_for(callback_event::ptw_success)) {
     c->ptw_success_callback(*this, final_ppn, level);
   }
   return UNIT;
 }
 
 unit ModelImpl::ptw_fail_callback(PTW_Error error_type, int64_t level, sbits pte_addr) {
-  for (auto c : m_callbacks) {
+  for (callbacks_if *c : callbacks_for(callback_event::ptw_fail)) {
     c->ptw_fail_callback(*this, error_type, level, pte_addr);
   }
   return UNIT;
 }
 
-unit ModelImpl::tlb_add_callback(TLB tlb, uint64_t index) {
-  for (auto c : m_callbacks) {
-    c->tlb_add_callback(*this, tlb, index);
+unit ModelImpl::tlb_add_callback(uint64_t index, TLB_Entry entry) {
+  for (callbacks_if *c : callbacks_for(callback_event::tlb_add)) {
+    c->tlb_add_callback(*this, index, entry);
   }
   return UNIT;
 }
 
 unit ModelImpl::tlb_flush_begin_callback(unit) {
-  for (auto c : m_callbacks) {
+  for (callbacks_if *c : callbacks_for(callback_event::tlb_flush_begin)) {
     c->tlb_flush_begin_callback(*this);
   }
   return UNIT;
 }
 
-unit ModelImpl::tlb_flush_callback(uint64_t index) {
-  for (auto c : m_callbacks) {
-    c->tlb_flush_callback(*this, index);
+unit ModelImpl::tlb_flush_callback(uint64_t index, TLB_Entry entry) {
+  for (callbacks_if *c : callbacks_for(callback_event::tlb_flush)) {
+    c->tlb_flush_callback(*this, index, entry);
   }
   return UNIT;
 }
 
-unit ModelImpl::tlb_flush_end_callback(TLB tlb) {
-  for (auto c : m_callbacks) {
-    c->tlb_flush_end_callback(*this, tlb);
+unit ModelImpl::tlb_flush_end_callback(unit) {
+  for (callbacks_if *c : callbacks_for(callback_event::tlb_flush_end)) {
+    c->tlb_flush_end_callback(*this);
   }
   return UNIT;
 }
@@ -214,6 +242,342 @@ mach_bits ModelImpl::plat_get_16_random_bits(unit) {
 // either directly in `load_reservation()` or by calling
 // `cancel_reservation()`.
 
+namespace {
+
+CheckpointValue checkpoint_value(uint64_t value) {
+  CheckpointValue result{64, std::vector<uint8_t>(8)};
+  for (unsigned i = 0; i < 8; ++i) {
+    result.bytes[i] = static_cast<uint8_t>(value >> (8 * i));
+  }
+  return result;
+}
+
+uint64_t checkpoint_u64(const CheckpointRegisters &registers, const std::string &name) {
+  auto it = registers.find(name);
+  if (it == registers.end() || it->second.bit_len != 64) {
+    throw std::runtime_error("Checkpoint is missing '" + name + "'");
+  }
+  uint64_t value = 0;
+  for (unsigned i = 0; i < 8; ++i) {
+    value |= static_cast<uint64_t>(it->second.bytes[i]) << (8 * i);
+  }
+  return value;
+}
+
+} // namespace
+
+// The Sail model visits its state in checkpoint_state(); the reservation
+// set is held here so it is added separately.
+
+CheckpointRegisters ModelImpl::save_registers() {
+  CheckpointRegisters registers;
+  m_checkpoint_save = &registers;
+  zcheckpoint_state(UNIT);
+  m_checkpoint_save = nullptr;
+
+  registers["reservation"] = checkpoint_value(m_reservation);
+  registers["reservation_addr"] = checkpoint_value(m_reservation_addr);
+  registers["reservation_valid"] = checkpoint_value(m_reservation_valid ? 1 : 0);
+  return registers;
+}
+
+void ModelImpl::restore_registers(const CheckpointRegisters &registers) {
+  m_checkpoint_restore = &registers;
+  m_checkpoint_error.clear();
+  zcheckpoint_state(UNIT);
+  m_checkpoint_restore = nullptr;
+  if (!m_checkpoint_error.empty()) {
+    throw std::runtime_error(m_checkpoint_error);
+  }
+
+  m_reservation = checkpoint_u64(registers, "reservation");
+  m_reservation_addr = checkpoint_u64(registers, "reservation_addr");
+  m_reservation_valid = checkpoint_u64(registers, "reservation_valid") != 0;
+}
+
+unit ModelImpl::checkpoint_bits(lbits *rop, const_sail_string name, lbits value) {
+  rop->len = value.len;
+  mpz_set(*rop->bits, *value.bits);
+  if (m_checkpoint_save != nullptr) {
+    CheckpointValue &saved = (*m_checkpoint_save)[name];
+    saved.bit_len = value.len;
+    saved.bytes.assign((value.len + 7) / 8, 0);
+    mpz_export(saved.bytes.data(), nullptr, -1, 1, 0, 0, *value.bits);
+    return UNIT;
+  }
+  if (m_checkpoint_restore == nullptr) {
+    return UNIT;
+  }
+
+  auto it = m_checkpoint_restore->find(name);
+  if (it == m_checkpoint_restore->end()) {
+    // Report the first error only; the current value is kept meanwhile.
+    if (m_checkpoint_error.empty()) {
+      m_checkpoint_error = std::string("Checkpoint is missing '") + name + "'";
+    }
+    return UNIT;
+  }
+  if (it->second.bit_len != value.len) {
+    if (m_checkpoint_error.empty()) {
+      m_checkpoint_error = std::string("Checkpoint has ") + std::to_string(it->second.bit_len) + " bits for '" + name +
+                           "' but the model expects " + std::to_string(value.len);
+    }
+    return UNIT;
+  }
+  mpz_import(*rop->bits, it->second.bytes.size(), -1, 1, 0, 0, it->second.bytes.data());
+  return UNIT;
+}
+
+// Main memory regions live in host memory; everything else (e.g. ROMs
+// outside the configured regions) stays in the Sail runtime's memory.
+
+bool ModelImpl::host_ram_contains(sbits paddr, int64_t width) {
+  m_host_ram_addr = paddr.bits;
+  m_host_ram_width = static_cast<uint64_t>(width);
+  m_host_ram_ptr = m_host_memory->host_ptr(m_host_ram_addr, m_host_ram_width);
+  return m_host_ram_ptr != nullptr;
+}
+
+// Memory is little-endian, so on a little-endian host an access of up to 8
+// bytes is a single copy to or from the low bytes of a word.
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "host memory accesses assume a little-endian host");
+
+sbits ModelImpl::host_ram_read(sbits paddr, int64_t width) {
+  const uint8_t *ptr = host_ram_ptr(paddr.bits, static_cast<uint64_t>(width));
+  assert(ptr != nullptr);
+  uint64_t bits = 0;
+  memcpy(&bits, ptr, static_cast<size_t>(width));
+  return sbits{static_cast<uint64_t>(width) * 8, bits};
+}
+
+unit ModelImpl::host_ram_write(sbits paddr, int64_t width, sbits value) {
+  uint8_t *ptr = host_ram_ptr(paddr.bits, static_cast<uint64_t>(width));
+  assert(ptr != nullptr);
+  memcpy(ptr, &value.bits, static_cast<size_t>(width));
+  return UNIT;
+}
+
+unit ModelImpl::host_ram_read_wide(lbits *data, sbits paddr, int64_t width) {
+  const uint8_t *ptr = host_ram_ptr(paddr.bits, static_cast<uint64_t>(width));
+  assert(ptr != nullptr);
+  data->len = static_cast<mp_bitcnt_t>(width) * 8;
+  mpz_import(*data->bits, static_cast<size_t>(width), -1, 1, 0, 0, ptr);
+  return UNIT;
+}
+
+unit ModelImpl::host_ram_write_wide(sbits paddr, int64_t width, lbits value) {
+  uint8_t *ptr = host_ram_ptr(paddr.bits, static_cast<uint64_t>(width));
+  assert(ptr != nullptr);
+  // mpz_export() omits leading zero bytes.
+  memset(ptr, 0, static_cast<size_t>(width));
+  mpz_export(ptr, nullptr, -1, 1, 0, 0, *value.bits);
+  return UNIT;
+}
+
+// Unless --no-host-vregs is given, the vector registers are held in
+// m_vregs, so that element accesses don't go through GMP. Whole registers
+// are only converted for the instructions that need them and for the
+// vreg_write callback.
+
+bool ModelImpl::host_vregs_enabled(unit) {
+  return m_host_vregs;
+}
+
+unit ModelImpl::host_vreg_read(lbits *data, int64_t reg) {
+  data->len = static_cast<mp_bitcnt_t>(m_vregs.vlen_bytes()) * 8;
+  mpz_import(*data->bits, m_vregs.vlen_bytes(), -1, 1, 0, 0, m_vregs.reg(static_cast<unsigned>(reg)));
+  return UNIT;
+}
+
+unit ModelImpl::host_vreg_write(int64_t reg, lbits value) {
+  uint8_t *ptr = m_vregs.reg(static_cast<unsigned>(reg));
+  // mpz_export() omits leading zero bytes.
+  memset(ptr, 0, m_vregs.vlen_bytes());
+  mpz_export(ptr, nullptr, -1, 1, 0, 0, *value.bits);
+  return UNIT;
+}
+
+sbits ModelImpl::host_vreg_read_element(int64_t reg, int64_t sew, int64_t offset) {
+  const uint64_t bits = m_vregs.read_element(
+    static_cast<unsigned>(reg),
+    static_cast<size_t>(offset / 8),
+    static_cast<size_t>(sew / 8)
+  );
+  return sbits{static_cast<uint64_t>(sew), bits};
+}
+
+unit ModelImpl::host_vreg_write_element(int64_t reg, int64_t sew, int64_t offset, sbits value) {
+  m_vregs.write_element(
+    static_cast<unsigned>(reg),
+    static_cast<size_t>(offset / 8),
+    static_cast<size_t>(sew / 8),
+    value.bits
+  );
+  return UNIT;
+}
+
+unit ModelImpl::host_vreg_written(int64_t reg) {
+  const auto &callbacks = callbacks_for(callback_event::vreg_write);
+  if (callbacks.empty()) {
+    return UNIT;
+  }
+  lbits value;
+  CREATE(lbits)(&value);
+  host_vreg_read(&value, reg);
+  for (callbacks_if *c : callbacks) {
+    c->vreg_write_callback(*this, static_cast<unsigned>(reg), value);
+  }
+  KILL(lbits)(&value);
+  return UNIT;
+}
+
+// Unit-stride vector loads and stores copy their elements in one go, unless
+// a callback needs to see the accesses and register writes one by one.
+bool ModelImpl::host_vreg_bulk_enabled(unit) {
+  for (callback_event event : {
+         callback_event::mem_read,
+         callback_event::mem_write,
+         callback_event::mem_exception,
+         callback_event::vreg_write,
+         callback_event::csr_full_write,
+         callback_event::ptw_start,
+         callback_event::ptw_step,
+         callback_event::ptw_success,
+         callback_event::ptw_fail,
+       }) {
+    if (!callbacks_for(event).empty()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+unit ModelImpl::host_vreg_load(int64_t reg, sbits paddr, int64_t width) {
+  const uint8_t *ptr = host_ram_ptr(paddr.bits, static_cast<uint64_t>(width));
+  assert(ptr != nullptr);
+  assert(m_vregs.contains(static_cast<unsigned>(reg), static_cast<size_t>(width)));
+  memcpy(m_vregs.reg(static_cast<unsigned>(reg)), ptr, static_cast<size_t>(width));
+  return UNIT;
+}
+
+unit ModelImpl::host_vreg_store(int64_t reg, sbits paddr, int64_t width, int64_t eew_bytes) {
+  uint8_t *ptr = host_ram_ptr(paddr.bits, static_cast<uint64_t>(width));
+  assert(ptr != nullptr);
+  assert(m_vregs.contains(static_cast<unsigned>(reg), static_cast<size_t>(width)));
+  assert(eew_bytes > 0);
+  memcpy(ptr, m_vregs.reg(static_cast<unsigned>(reg)), static_cast<size_t>(width));
+
+  // The store doesn't go through mem_write_callback, so cancel the
+  // reservations that storing the elements one by one would have.
+  if (m_reservation_invalidate_on_same_hart_store) {
+    for (int64_t offset = 0; offset < width && m_reservation_valid; offset += eew_bytes) {
+      if (match_reservation(sbits{paddr.len, paddr.bits + static_cast<uint64_t>(offset)})) {
+        cancel_reservation(UNIT);
+      }
+    }
+  }
+  cancel_other_reservations(paddr.bits, static_cast<uint64_t>(width));
+  return UNIT;
+}
+
+namespace {
+
+// `op` is `num_of_vector_kernel_op()` of a Sail `vector_kernel_op`, i.e.
+// its position in the enum (see vext_regs.sail).
+VectorKernelOp vector_kernel_op(int64_t op) {
+  switch (op) {
+  case 0:
+    return VectorKernelOp::add;
+  case 1:
+    return VectorKernelOp::sub;
+  case 2:
+    return VectorKernelOp::mul;
+  case 3:
+    return VectorKernelOp::macc;
+  }
+  assert(false);
+  return VectorKernelOp::add;
+}
+
+VectorKernelArgs vector_kernel_args(
+  VRegFile &vregs,
+  int64_t sew,
+  int64_t vd,
+  int64_t vs2,
+  int64_t vs1,
+  bool use_scalar,
+  uint64_t scalar,
+  bool masked,
+  int64_t start,
+  int64_t end
+) {
+  // Every register group holds `end` elements, because vl <= VLMAX.
+  const size_t group_bytes = static_cast<size_t>(end) * static_cast<size_t>(sew / 8);
+  assert(vregs.contains(static_cast<unsigned>(vd), group_bytes));
+  assert(vregs.contains(static_cast<unsigned>(vs2), group_bytes));
+  assert(use_scalar || vregs.contains(static_cast<unsigned>(vs1), group_bytes));
+
+  VectorKernelArgs args;
+  args.vd = vregs.reg(static_cast<unsigned>(vd));
+  args.vs2 = vregs.reg(static_cast<unsigned>(vs2));
+  args.vs1 = use_scalar ? nullptr : vregs.reg(static_cast<unsigned>(vs1));
+  args.scalar = scalar;
+  args.mask = masked ? vregs.reg(0) : nullptr;
+  args.start = static_cast<size_t>(start);
+  args.end = static_cast<size_t>(end);
+  return args;
+}
+
+} // namespace
+
+bool ModelImpl::host_vector_int_kernel(
+  int64_t op,
+  int64_t sew,
+  int64_t vd,
+  int64_t vs2,
+  int64_t vs1,
+  bool use_scalar,
+  uint64_t scalar,
+  bool masked,
+  int64_t start,
+  int64_t end
+) {
+  return vector_int_kernel(
+    vector_kernel_op(op),
+    static_cast<size_t>(sew / 8),
+    vector_kernel_args(m_vregs, sew, vd, vs2, vs1, use_scalar, scalar, masked, start, end)
+  );
+}
+
+// Floating point instructions are only computed on the host with
+// `--host-fpu`, and not when a callback needs to see the fflags written
+// after each element.
+int64_t ModelImpl::host_vector_fp_kernel(
+  int64_t op,
+  int64_t sew,
+  uint64_t rm,
+  int64_t vd,
+  int64_t vs2,
+  int64_t vs1,
+  bool use_scalar,
+  uint64_t scalar,
+  bool masked,
+  int64_t start,
+  int64_t end
+) {
+  if (!softfloat_host_fpu_enabled() || !callbacks_for(callback_event::csr_full_write).empty()) {
+    return -1;
+  }
+  const std::optional<uint64_t> fflags = vector_fp_kernel(
+    vector_kernel_op(op),
+    static_cast<size_t>(sew / 8),
+    rm,
+    vector_kernel_args(m_vregs, sew, vd, vs2, vs1, use_scalar, scalar, masked, start, end),
+    m_vector_scratch.data()
+  );
+  return fflags.has_value() ? static_cast<int64_t>(*fflags) : -1;
+}
+
 unit ModelImpl::load_reservation(sbits addr, uint64_t width) {
   m_reservation_addr = addr.bits;
   m_reservation = addr.bits & m_reservation_set_addr_mask;
@@ -240,6 +604,42 @@ bool ModelImpl::valid_reservation(unit) {
   return m_reservation_valid;
 }
 
+bool ModelImpl::reservation_overlaps(uint64_t addr, uint64_t width) const {
+  const uint64_t set_size = ~m_reservation_set_addr_mask + 1;
+  return m_reservation_valid && addr < m_reservation + set_size && m_reservation < addr + width;
+}
+
+// A store always breaks the reservations of other harts on the same set.
+void ModelImpl::cancel_other_reservations(uint64_t addr, uint64_t width) {
+  for (ModelImpl *hart : m_harts) {
+    if (hart != this && hart->reservation_overlaps(addr, width)) {
+      hart->cancel_reservation(UNIT);
+    }
+  }
+}
+
+// Accesses to the CLINT registers of other harts are done on their model.
+
+uint64_t ModelImpl::clint_remote_read(uint64_t hart, uint64_t offset, int64_t width) {
+  assert(hart < m_harts.size());
+  return m_harts[hart]->zclint_read_from_remote(offset, width);
+}
+
+unit ModelImpl::clint_remote_write(uint64_t hart, uint64_t offset, int64_t width, uint64_t value) {
+  assert(hart < m_harts.size());
+  m_harts[hart]->zclint_write_from_remote(offset, width, value);
+  return UNIT;
+}
+
+unit ModelImpl::clint_mtime_written(uint64_t mtime) {
+  for (ModelImpl *hart : m_harts) {
+    if (hart != this) {
+      hart->zset_mtime(mtime);
+    }
+  }
+  return UNIT;
+}
+
 unit ModelImpl::plat_term_write(mach_bits s) {
   char c = static_cast<char>(s);
   if (write(m_term_fd, &c, sizeof(c)) < 0) {
@@ -258,23 +658,39 @@ unit ModelImpl::print_string(const_sail_string prefix, const_sail_string msg) {
 }
 
 unit ModelImpl::print_log(const_sail_string s) {
-  fprintf(m_trace_log, "%s\n", s);
+  m_trace->line(s);
   return UNIT;
 }
 
-unit ModelImpl::print_log_instr(const_sail_string s, uint64_t pc) {
-  auto maybe_symbol = symbolize_address(m_symbols, pc);
-  if (maybe_symbol.has_value()) {
-    fprintf(m_trace_log, "%-80s    %s+%" PRIu64 "\n", s, maybe_symbol->second.c_str(), pc - maybe_symbol->first);
-  } else {
-    fprintf(m_trace_log, "%s\n", s);
+unit ModelImpl::print_log_instr(
+  uint64_t step,
+  const_sail_string privilege,
+  sbits pc,
+  sbits opcode,
+  const_sail_string disassembly
+) {
+  TraceInstr instr;
+  instr.step = step;
+  if (m_harts.size() > 1) {
+    instr.hart = static_cast<int64_t>(m_hart_index);
+  }
+  instr.privilege = privilege;
+  instr.pc = pc.bits;
+  instr.pc_digits = static_cast<int>(pc.len / 4);
+  instr.opcode = opcode.bits;
+  instr.opcode_digits = static_cast<int>(opcode.len / 4);
+  instr.disassembly = disassembly;
+  if (const Symbol *symbol = m_symbols.lookup(pc.bits)) {
+    instr.symbol = symbol->name.c_str();
+    instr.symbol_offset = pc.bits - symbol->address;
   }
+  m_trace->instr(instr);
   return UNIT;
 }
 
 unit ModelImpl::print_step(unit) {
   if (m_config_print_step) {
-    fprintf(m_trace_log, "\n");
+    print_log("");
   }
   return UNIT;
 }
@@ -347,17 +763,21 @@ void ModelImpl::set_config_print_step(bool on) {
   m_config_print_step = on;
 }
 
-void ModelImpl::set_elf_symbols(std::map<uint64_t, std::string> symbols) {
+void ModelImpl::set_elf_symbols(SymbolTable symbols) {
   m_symbols = std::move(symbols);
 }
 
+SymbolTable &ModelImpl::elf_symbols() {
+  return m_symbols;
+}
+
 void ModelImpl::set_term_fd(int fd) {
   m_term_fd = fd;
 }
 
-void ModelImpl::set_trace_log(FILE *log) {
-  assert(log != nullptr);
-  m_trace_log = log;
+void ModelImpl::set_trace(TraceSink *trace) {
+  assert(trace != nullptr);
+  m_trace = trace;
 }
 
 void ModelImpl::init_platform_constants() {
@@ -383,12 +803,16 @@ void ModelImpl::init_sail(
 }
 
 void ModelImpl::init_sail_impl() {
-  // zset_pc_reset_address must be called before zinit_model
-  // because reset happens inside init_model().
+  // zset_hart_index and zset_pc_reset_address must be called before
+  // zinit_model because reset happens inside init_model().
+  zset_hart_index(m_hart_index);
   zset_pc_reset_address(m_elf_entry);
   if (m_htif_tohost_address.has_value()) {
     zenable_htif(m_htif_tohost_address.value());
   }
+  m_vregs.reset((size_t{1} << zvlen_exp) / 8);
+  // The largest register group is 8 registers.
+  m_vector_scratch.assign(8 * m_vregs.vlen_bytes(), 0);
   zinit_model(m_config_file.c_str());
   zinit_boot_requirements(UNIT);
 }
@@ -407,6 +831,25 @@ void ModelImpl::model_fini() {
   hart::Model::model_fini();
 }
 
+void ModelImpl::init_host_memory() {
+  m_host_memory->map_regions(main_memory_regions());
+  m_host_ram_ptr = nullptr;
+}
+
+void ModelImpl::share_host_memory(const ModelImpl &other) {
+  m_host_memory = other.m_host_memory;
+  m_host_ram_ptr = nullptr;
+}
+
+void ModelImpl::set_hart_index(uint64_t index) {
+  m_hart_index = index;
+}
+
+void ModelImpl::set_harts(std::vector<ModelImpl *> harts) {
+  assert(m_hart_index < harts.size() && harts[m_hart_index] == this);
+  m_harts = std::move(harts);
+}
+
 bool ModelImpl::config_is_valid() {
   return zconfig_is_valid(UNIT);
 }
@@ -483,10 +926,54 @@ std::string ModelImpl::ptw_error_to_string(PTW_Error error_type) {
   return str;
 }
 
+std::string ModelImpl::opcode_to_string(uint64_t opcode, bool compressed) {
+  sail_string sstr = nullptr;
+  CREATE(sail_string)(&sstr);
+  zopcode_to_str(&sstr, opcode, compressed);
+  std::string str(sstr);
+  KILL(sail_string)(&sstr);
+  return str;
+}
+
+std::string ModelImpl::opcode_extension_to_string(uint64_t opcode, bool compressed) {
+  sail_string sstr = nullptr;
+  CREATE(sail_string)(&sstr);
+  zopcode_extension_to_str(&sstr, opcode, compressed);
+  std::string str(sstr);
+  KILL(sail_string)(&sstr);
+  return str;
+}
+
+std::string ModelImpl::decode_context_to_string() {
+  sail_string sstr = nullptr;
+  CREATE(sail_string)(&sstr);
+  zdecode_context_to_str(&sstr, UNIT);
+  std::string str(sstr);
+  KILL(sail_string)(&sstr);
+  return str;
+}
+
+std::string ModelImpl::privilege_index_to_string(uint64_t index) {
+  sail_string sstr = nullptr;
+  CREATE(sail_string)(&sstr);
+  zprivLevel_to_str(&sstr, static_cast<decltype(zcur_privilege)>(index));
+  std::string str(sstr);
+  KILL(sail_string)(&sstr);
+  return str;
+}
+
 void ModelImpl::tick_clock() {
   ztick_clock(UNIT);
 }
 
+uint64_t ModelImpl::ticks_until_timer_change() {
+  return zticks_until_timer_change(UNIT);
+}
+
+void ModelImpl::fast_forward_clock(uint64_t ticks) {
+  zfast_forward_clock(ticks);
+}
+
 bool ModelImpl::try_step(int64_t step_no, bool exit_wait) {
   sail_int sail_step;
   CREATE(sail_int)(&sail_step);
@@ -496,6 +983,50 @@ bool ModelImpl::try_step(int64_t step_no, bool exit_wait) {
   return is_waiting;
 }
 
+// This does what run_sail() does around each step, but only the parts that
+// are needed for a single hart with no per-step tracing, so the loop stays
+// inside the model and the step number's Sail integer is only allocated once.
+ModelImpl::RunResult
+ModelImpl::run(uint64_t max_steps, int64_t step_no, uint64_t insns_per_tick, uint64_t &insns_since_tick) {
+  RunResult result;
+  m_stop_requested = false;
+
+  sail_int sail_step;
+  CREATE(sail_int)(&sail_step);
+  while (result.steps < max_steps) {
+    call_pre_step_callbacks(false);
+    CONVERT_OF(sail_int, mach_int)(&sail_step, static_cast<mach_int>(step_no + static_cast<int64_t>(result.steps)));
+    const bool is_waiting = ztry_step(sail_step, /* exit_wait */ true);
+    if (have_exception) {
+      result.reason = RunStop::exception;
+      break;
+    }
+    call_post_step_callbacks(is_waiting);
+    if (is_waiting) {
+      result.reason = RunStop::waiting;
+      break;
+    }
+    result.steps++;
+
+    if (++insns_since_tick == insns_per_tick) {
+      insns_since_tick = 0;
+      ztick_clock(UNIT);
+    }
+    if (zhtif_done) {
+      result.reason = RunStop::htif_done;
+      break;
+    }
+    if (m_stop_requested) {
+      result.reason = RunStop::stop_requested;
+      break;
+    }
+  }
+  KILL(sail_int)(&sail_step);
+
+  m_stop_requested = false;
+  return result;
+}
+
 int64_t ModelImpl::xlen() const {
   return zxlen;
 }
@@ -524,6 +1055,10 @@ uint64_t ModelImpl::fcsr() const {
   return zfcsr.zbits;
 }
 
+uint64_t ModelImpl::privilege_index() const {
+  return static_cast<uint64_t>(zcur_privilege);
+}
+
 uint64_t ModelImpl::htif_exit_code() const {
   return zhtif_exit_code;
 }
@@ -532,6 +1067,34 @@ bool ModelImpl::htif_done() const {
   return zhtif_done;
 }
 
+uint64_t ModelImpl::decode_context_generation() const {
+  return zdecode_context_generation;
+}
+
+uint64_t ModelImpl::decode_cache_hits() const {
+  return zdecode_cache_hits;
+}
+
+uint64_t ModelImpl::decode_cache_misses() const {
+  return zdecode_cache_misses;
+}
+
+uint64_t ModelImpl::tlb_hits() const {
+  return ztlb_hits;
+}
+
+uint64_t ModelImpl::tlb_misses() const {
+  return ztlb_misses;
+}
+
+uint64_t ModelImpl::walk_cache_hits() const {
+  return zwalk_cache_hits;
+}
+
+uint64_t ModelImpl::walk_cache_misses() const {
+  return zwalk_cache_misses;
+}
+
 bool ModelImpl::had_exception() const {
   return have_exception;
 }
@@ -582,3 +1145,48 @@ void ModelImpl::set_fcsr(uint64_t val) {
   // Writing this CSR has side-effects: it dirties the FD context.
   zwrite_fcsr(frm, fflags);
 }
+
+uint8_t ModelImpl::read_mem_byte(uint64_t addr) {
+  if (const uint8_t *ptr = m_host_memory->host_ptr(addr, 1)) {
+    return *ptr;
+  }
+  return static_cast<uint8_t>(read_mem(addr));
+}
+
+void ModelImpl::write_mem_byte(uint64_t addr, uint8_t byte) {
+  if (uint8_t *ptr = m_host_memory->host_ptr(addr, 1)) {
+    *ptr = byte;
+    return;
+  }
+  write_mem(addr, byte);
+}
+
+void ModelImpl::read_mem_bytes(uint64_t addr, uint8_t *data, uint64_t length) {
+  if (const uint8_t *ptr = m_host_memory->host_ptr(addr, length)) {
+    memcpy(data, ptr, static_cast<size_t>(length));
+    return;
+  }
+  for (uint64_t i = 0; i < length; ++i) {
+    data[i] = read_mem_byte(addr + i);
+  }
+}
+
+void ModelImpl::write_mem_bytes(uint64_t addr, const uint8_t *data, uint64_t length) {
+  if (uint8_t *ptr = m_host_memory->host_ptr(addr, length)) {
+    memcpy(ptr, data, static_cast<size_t>(length));
+    return;
+  }
+  for (uint64_t i = 0; i < length; ++i) {
+    write_mem_byte(addr + i, data[i]);
+  }
+}
+
+void ModelImpl::zero_mem_bytes(uint64_t addr, uint64_t length) {
+  if (uint8_t *ptr = m_host_memory->host_ptr(addr, length)) {
+    HostMemory::zero(ptr, length);
+    return;
+  }
+  for (uint64_t i = 0; i < length; ++i) {
+    write_mem_byte(addr + i, 0);
+  }
+}
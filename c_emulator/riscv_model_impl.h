@@ -1,20 +1,21 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <cstdio>
-#include <map>
 #include <memory>
 #include <optional>
 #include <random>
 #include <vector>
 
+#include "checkpoint.h"
+#include "host_memory.h"
+#include "riscv_callback_events.h"
 #include "sail.h"
 #include "sail_riscv_model.h"
-
-struct MemoryRegion {
-  uint64_t base = 0;
-  uint64_t size = 0;
-};
+#include "symbol_table.h"
+#include "trace_format.h"
+#include "vreg_file.h"
 
 // Model wrapped with an implementation of its platform callbacks.
 class ModelImpl final : private hart::Model {
@@ -24,19 +25,46 @@ public:
   using Privilege = hart::ztuple_z8z5enumz0zzPrivilegezCz0z5unitz9;
   using MemoryAccessType = hart::zMemoryAccessTypezIEmem_payloadz5zK;
   using PTW_Error = hart::zPTW_Error;
-  using TLB = hart::zz5vecz8z5unionz0zzoptionzzIRTLB_EntryzzKz9;
+  using TLB_Entry = hart::zTLB_Entry;
+
+  // Why run() returned.
+  enum class RunStop {
+    // `max_steps` steps were run.
+    step_limit,
+    // The last step left the hart waiting for an interrupt or event.
+    waiting,
+    // The program signalled completion through HTIF.
+    htif_done,
+    // The model threw an exception; see string_of_current_exception().
+    exception,
+    // A callback called request_stop(), e.g. at a breakpoint.
+    stop_requested,
+  };
+
+  struct RunResult {
+    RunStop reason = RunStop::step_limit;
+    // The number of steps run. A final step that left the hart waiting is
+    // not counted, as it did not retire or trap.
+    uint64_t steps = 0;
+  };
 
   // callbacks
 
   void register_callback(std::shared_ptr<callbacks_if> cb);
   void remove_callback(std::shared_ptr<callbacks_if> cb);
 
+  // Make run() return after the current step.
+  void request_stop();
+
   void call_pre_step_callbacks(bool is_waiting);
   void call_post_step_callbacks(bool is_waiting);
 
   // configuration
 
   void set_enable_experimental_extensions(bool en);
+  // Hold the vector registers in host buffers (the default). Must be
+  // called before model_init().
+  void set_host_vregs(bool on);
   void set_reservation_set_size_exp(uint64_t exponent);
   void set_reservation_require_exact_addr_match(bool require_exact_addr_match);
   void set_reservation_invalidate_on_same_hart_store(bool invalidate_on_same_hart_store);
@@ -52,9 +80,11 @@ public:
   void set_config_rvfi(bool on);
   void set_config_use_abi_names(bool on);
 
-  void set_elf_symbols(std::map<uint64_t, std::string> symbols);
+  void set_elf_symbols(SymbolTable symbols);
+  SymbolTable &elf_symbols();
   void set_term_fd(int fd);
-  void set_trace_log(FILE *log);
+  // Where trace output goes; stdout as text by default.
+  void set_trace(TraceSink *trace);
 
   // initialization
 
@@ -63,12 +93,40 @@ public:
   void reinit_sail();
   void model_init();
   void model_fini();
+  // Back the configured main memory regions with host memory. Must be
+  // called after model_init() and before anything is loaded into memory.
+  void init_host_memory();
+  // Use the host memory of `other` instead, for another hart on the same
+  // platform.
+  void share_host_memory(const ModelImpl &other);
+
+  // multiple harts
+
+  // Set the index of this hart on the platform, which selects its
+  // mhartid and CLINT registers. Must be called before init_sail().
+  void set_hart_index(uint64_t index);
+  uint64_t hart_index() const {
+    return m_hart_index;
+  }
+  // All the harts of the platform, in index order, including this one.
+  // Stores break their reservations and CLINT accesses are passed to them.
+  void set_harts(std::vector<ModelImpl *> harts);
 
   // string conversions
 
   std::string memory_access_type_to_string(MemoryAccessType access_type);
   std::string privilege_to_string(Privilege privilege);
   std::string ptw_error_to_string(PTW_Error error_type);
+  // The assembly of an instruction as it would be decoded now.
+  std::string opcode_to_string(uint64_t opcode, bool compressed);
+  // The name of the extension that defines an instruction as it would be
+  // decoded now, as in the ISA string, or "i" for the base ISA.
+  std::string opcode_extension_to_string(uint64_t opcode, bool compressed);
+  // The state that opcodes are decoded in, which can only have changed
+  // if decode_context_generation() has.
+  std::string decode_context_to_string();
+  // The name of the privilege with the given privilege_index().
+  std::string privilege_index_to_string(uint64_t index);
 
   // access to model configuration
 
@@ -81,7 +139,15 @@ public:
   // read access to model state
 
   void tick_clock();
+  uint64_t ticks_until_timer_change();
+  void fast_forward_clock(uint64_t ticks);
   bool try_step(int64_t step_no, bool exit_wait);
+  // Run up to `max_steps` steps of an active (not waiting) hart, numbered
+  // from `step_no`, without returning to the caller in between. The clock
+  // is ticked after every `insns_per_tick` steps, counting on from
+  // `insns_since_tick`, which is updated. This only ticks this hart's
+  // clock, so it is only suitable for a single hart.
+  RunResult run(uint64_t max_steps, int64_t step_no, uint64_t insns_per_tick, uint64_t &insns_since_tick);
 
   int64_t xlen() const;
   int64_t flen() const;
@@ -93,6 +159,21 @@ public:
   bool had_exception() const;
   uint64_t pc() const;
   uint64_t fcsr() const;
+  // The current privilege, as its position in the model's Privilege enum.
+  uint64_t privilege_index() const;
+
+  // Increases whenever the state that opcodes are decoded in may change.
+  uint64_t decode_context_generation() const;
+
+  // Decoded-instruction cache statistics.
+  uint64_t decode_cache_hits() const;
+  uint64_t decode_cache_misses() const;
+
+  // TLB statistics.
+  uint64_t tlb_hits() const;
+  uint64_t tlb_misses() const;
+  uint64_t walk_cache_hits() const;
+  uint64_t walk_cache_misses() const;
 
   // These state accessors are not const due to the generated read
   // accessors not being marked const in hart::Model.
@@ -108,6 +189,20 @@ public:
   void set_pc(uint64_t val);
   void set_fcsr(uint64_t val);
 
+  // physical memory access for the harness and debugger
+
+  uint8_t read_mem_byte(uint64_t addr);
+  void write_mem_byte(uint64_t addr, uint8_t byte);
+  void read_mem_bytes(uint64_t addr, uint8_t *data, uint64_t length);
+  void write_mem_bytes(uint64_t addr, const uint8_t *data, uint64_t length);
+  void zero_mem_bytes(uint64_t addr, uint64_t length);
+
+  // checkpointing (see checkpoint.h)
+
+  CheckpointRegisters save_registers();
+  // Throws an exception if any register is missing or has the wrong width.
+  void restore_registers(const CheckpointRegisters &registers);
+
   // RVFI support
 
   friend class rvfi_handler;
@@ -130,6 +225,7 @@ private:
   // makes two csr_full_write_callback calls on RV32.
   unit csr_full_write_callback(const_sail_string csr_name, unsigned reg, sbits value) override;
   unit csr_full_read_callback(const_sail_string csr_name, unsigned reg, sbits value) override;
+  bool csr_callbacks_enabled(unit) override;
   unit vreg_write_callback(unsigned reg, lbits value) override;
   unit pc_write_callback(sbits new_pc) override;
   unit redirect_callback(sbits new_pc) override;
@@ -142,17 +238,69 @@ private:
   unit ptw_step_callback(int64_t level, sbits pte_addr, uint64_t pte) override;
   unit ptw_success_callback(uint64_t final_ppn, int64_t level) override;
   unit ptw_fail_callback(PTW_Error error_type, int64_t level, sbits pte_addr) override;
-  unit tlb_add_callback(TLB tlb, uint64_t index) override;
+  unit tlb_add_callback(uint64_t index, TLB_Entry entry) override;
   unit tlb_flush_begin_callback(unit) override;
-  unit tlb_flush_callback(uint64_t index) override;
-  unit tlb_flush_end_callback(TLB tlb) override;
+  unit tlb_flush_callback(uint64_t index, TLB_Entry entry) override;
+  unit tlb_flush_end_callback(unit) override;
   // Provides entropy for the scalar cryptography extension.
   mach_bits plat_get_16_random_bits(unit) override;
 
+  bool host_ram_contains(sbits paddr, int64_t width) override;
+  sbits host_ram_read(sbits paddr, int64_t width) override;
+  unit host_ram_write(sbits paddr, int64_t width, sbits value) override;
+  unit host_ram_read_wide(lbits *data, sbits paddr, int64_t width) override;
+  unit host_ram_write_wide(sbits paddr, int64_t width, lbits value) override;
+
+  bool host_vregs_enabled(unit) override;
+  unit host_vreg_read(lbits *data, int64_t reg) override;
+  unit host_vreg_write(int64_t reg, lbits value) override;
+  sbits host_vreg_read_element(int64_t reg, int64_t sew, int64_t offset) override;
+  unit host_vreg_write_element(int64_t reg, int64_t sew, int64_t offset, sbits value) override;
+  unit host_vreg_written(int64_t reg) override;
+  bool host_vreg_bulk_enabled(unit) override;
+  unit host_vreg_load(int64_t reg, sbits paddr, int64_t width) override;
+  unit host_vreg_store(int64_t reg, sbits paddr, int64_t width, int64_t eew_bytes) override;
+  bool host_vector_int_kernel(
+    int64_t op,
+    int64_t sew,
+    int64_t vd,
+    int64_t vs2,
+    int64_t vs1,
+    bool use_scalar,
+    uint64_t scalar,
+    bool masked,
+    int64_t start,
+    int64_t end
+  ) override;
+  int64_t host_vector_fp_kernel(
+    int64_t op,
+    int64_t sew,
+    uint64_t rm,
+    int64_t vd,
+    int64_t vs2,
+    int64_t vs1,
+    bool use_scalar,
+    uint64_t scalar,
+    bool masked,
+    int64_t start,
+    int64_t end
+  ) override;
+
+  unit checkpoint_bits(lbits *rop, const_sail_string name, lbits value) override;
+
   unit load_reservation(sbits, uint64_t) override;
   bool match_reservation(sbits) override;
   unit cancel_reservation(unit) override;
   bool valid_reservation(unit) override;
+  // Whether a store to `[addr, addr + width)` hits the reservation set.
+  bool reservation_overlaps(uint64_t addr, uint64_t width) const;
+  // Cancel the reservations of the other harts that a store to
+  // `[addr, addr + width)` hits.
+  void cancel_other_reservations(uint64_t addr, uint64_t width);
+
+  uint64_t clint_remote_read(uint64_t hart, uint64_t offset, int64_t width) override;
+  unit clint_remote_write(uint64_t hart, uint64_t offset, int64_t width, uint64_t value) override;
+  unit clint_mtime_written(uint64_t mtime) override;
 
   unit plat_term_write(mach_bits) override;
 
@@ -161,7 +309,13 @@ private:
   unit print_string(const_sail_string prefix, const_sail_string msg) override;
 
   unit print_log(const_sail_string s) override;
-  unit print_log_instr(const_sail_string s, uint64_t pc) override;
+  unit print_log_instr(
+    uint64_t step,
+    const_sail_string privilege,
+    sbits pc,
+    sbits opcode,
+    const_sail_string disassembly
+  ) override;
   unit print_step(unit) override;
 
   bool get_config_print_instr(unit) override;
@@ -189,10 +343,48 @@ private:
   std::string m_config_file = {};
   std::optional<uint64_t> m_htif_tohost_address = {};
 
-  std::map<uint64_t, std::string> m_symbols;
+  SymbolTable m_symbols;
   int m_term_fd = 1;
 
+  // The registered callbacks, and for each event the ones subscribed to
+  // it. The per-event lists don't own the callbacks, so dispatching an
+  // event doesn't touch any reference counts.
   std::vector<std::shared_ptr<callbacks_if>> m_callbacks;
+  std::array<std::vector<callbacks_if *>, num_callback_events> m_event_callbacks;
+  bool m_stop_requested = false;
+
+  const std::vector<callbacks_if *> &callbacks_for(callback_event event) const {
+    return m_event_callbacks[static_cast<size_t>(event)];
+  }
+
+  // Shared by all harts of the platform.
+  std::shared_ptr<HostMemory> m_host_memory = std::make_shared<HostMemory>();
+  // The result of the last host_ram_contains(), which the model nearly
+  // always follows with a read or write of the same bytes.
+  uint64_t m_host_ram_addr = 0;
+  uint64_t m_host_ram_width = 0;
+  uint8_t *m_host_ram_ptr = nullptr;
+
+  uint8_t *host_ram_ptr(uint64_t addr, uint64_t width) {
+    if (m_host_ram_ptr != nullptr && addr == m_host_ram_addr && width == m_host_ram_width) {
+      return m_host_ram_ptr;
+    }
+    return m_host_memory->host_ptr(addr, width);
+  }
+
+  // The vector registers of this hart.
+  VRegFile m_vregs;
+  // Where host_vector_fp_kernel() computes a register group, so that it
+  // is unchanged if softfloat has to be used instead.
+  std::vector<uint8_t> m_vector_scratch;
+
+  uint64_t m_hart_index = 0;
+  std::vector<ModelImpl *> m_harts;
+
+  // At most one of these is set, while saving or restoring a checkpoint.
+  CheckpointRegisters *m_checkpoint_save = nullptr;
+  const CheckpointRegisters *m_checkpoint_restore = nullptr;
+  std::string m_checkpoint_error = {};
 
   uint64_t m_reservation = 0;
   uint64_t m_reservation_addr = 0;
@@ -203,6 +395,7 @@ private:
   bool m_reservation_invalidate_on_same_hart_store = false;
 
   bool m_enable_experimental_extensions = false;
+  bool m_host_vregs = true;
 
   static unsigned seed() {
     std::random_device rd;
@@ -212,6 +405,7 @@ private:
   // Randomly seeded PRNG.
   std::mt19937_64 m_gen64{seed()};
 
-  // Trace log file
-  FILE *m_trace_log = stdout;
+  // Trace output.
+  TextTraceSink m_stdout_trace{stdout};
+  TraceSink *m_trace = &m_stdout_trace;
 };
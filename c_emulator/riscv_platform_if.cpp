@@ -65,6 +65,10 @@ unit PlatformInterface::csr_full_read_callback(
   return UNIT;
 }
 
+bool PlatformInterface::csr_callbacks_enabled(unit) {
+  return true;
+}
+
 unit PlatformInterface::vreg_write_callback([[maybe_unused]] unsigned reg, [[maybe_unused]] lbits value) {
   return UNIT;
 }
@@ -115,10 +119,7 @@ unit PlatformInterface::ptw_fail_callback(
   return UNIT;
 }
 
-unit PlatformInterface::tlb_add_callback(
-  [[maybe_unused]] hart::zz5vecz8z5unionz0zzoptionzzIRTLB_EntryzzKz9 tlb,
-  [[maybe_unused]] uint64_t index
-) {
+unit PlatformInterface::tlb_add_callback([[maybe_unused]] uint64_t index, [[maybe_unused]] hart::zTLB_Entry entry) {
   return UNIT;
 }
 
@@ -126,11 +127,11 @@ unit PlatformInterface::tlb_flush_begin_callback(unit) {
   return UNIT;
 }
 
-unit PlatformInterface::tlb_flush_callback([[maybe_unused]] uint64_t index) {
+unit PlatformInterface::tlb_flush_callback([[maybe_unused]] uint64_t index, [[maybe_unused]] hart::zTLB_Entry entry) {
   return UNIT;
 }
 
-unit PlatformInterface::tlb_flush_end_callback([[maybe_unused]] hart::zz5vecz8z5unionz0zzoptionzzIRTLB_EntryzzKz9 tlb) {
+unit PlatformInterface::tlb_flush_end_callback(unit) {
   return UNIT;
 }
 
@@ -138,6 +139,131 @@ mach_bits PlatformInterface::plat_get_16_random_bits(unit) {
   return 0;
 }
 
+bool PlatformInterface::host_ram_contains([[maybe_unused]] sbits paddr, [[maybe_unused]] int64_t width) {
+  return false;
+}
+
+sbits PlatformInterface::host_ram_read([[maybe_unused]] sbits paddr, int64_t width) {
+  // Only reachable if host_ram_contains() is overridden without this.
+  return sbits{static_cast<uint64_t>(width) * 8, 0};
+}
+
+unit PlatformInterface::host_ram_write(
+  [[maybe_unused]] sbits paddr,
+  [[maybe_unused]] int64_t width,
+  [[maybe_unused]] sbits value
+) {
+  return UNIT;
+}
+
+unit PlatformInterface::host_ram_read_wide(lbits *data, [[maybe_unused]] sbits paddr, int64_t width) {
+  // Only reachable if host_ram_contains() is overridden without this.
+  data->len = static_cast<mp_bitcnt_t>(width) * 8;
+  mpz_set_ui(*data->bits, 0);
+  return UNIT;
+}
+
+unit PlatformInterface::host_ram_write_wide(
+  [[maybe_unused]] sbits paddr,
+  [[maybe_unused]] int64_t width,
+  [[maybe_unused]] lbits value
+) {
+  return UNIT;
+}
+
+bool PlatformInterface::host_vregs_enabled(unit) {
+  return false;
+}
+
+unit PlatformInterface::host_vreg_read(lbits *data, [[maybe_unused]] int64_t reg) {
+  // Only reachable if host_vregs_enabled() is overridden without this.
+  mpz_set_ui(*data->bits, 0);
+  return UNIT;
+}
+
+unit PlatformInterface::host_vreg_write([[maybe_unused]] int64_t reg, [[maybe_unused]] lbits value) {
+  return UNIT;
+}
+
+sbits PlatformInterface::host_vreg_read_element(
+  [[maybe_unused]] int64_t reg,
+  int64_t sew,
+  [[maybe_unused]] int64_t offset
+) {
+  return sbits{static_cast<uint64_t>(sew), 0};
+}
+
+unit PlatformInterface::host_vreg_write_element(
+  [[maybe_unused]] int64_t reg,
+  [[maybe_unused]] int64_t sew,
+  [[maybe_unused]] int64_t offset,
+  [[maybe_unused]] sbits value
+) {
+  return UNIT;
+}
+
+unit PlatformInterface::host_vreg_written([[maybe_unused]] int64_t reg) {
+  return UNIT;
+}
+
+bool PlatformInterface::host_vreg_bulk_enabled(unit) {
+  return false;
+}
+
+unit PlatformInterface::host_vreg_load(
+  [[maybe_unused]] int64_t reg,
+  [[maybe_unused]] sbits paddr,
+  [[maybe_unused]] int64_t width
+) {
+  return UNIT;
+}
+
+unit PlatformInterface::host_vreg_store(
+  [[maybe_unused]] int64_t reg,
+  [[maybe_unused]] sbits paddr,
+  [[maybe_unused]] int64_t width,
+  [[maybe_unused]] int64_t eew_bytes
+) {
+  return UNIT;
+}
+
+bool PlatformInterface::host_vector_int_kernel(
+  [[maybe_unused]] int64_t op,
+  [[maybe_unused]] int64_t sew,
+  [[maybe_unused]] int64_t vd,
+  [[maybe_unused]] int64_t vs2,
+  [[maybe_unused]] int64_t vs1,
+  [[maybe_unused]] bool use_scalar,
+  [[maybe_unused]] uint64_t scalar,
+  [[maybe_unused]] bool masked,
+  [[maybe_unused]] int64_t start,
+  [[maybe_unused]] int64_t end
+) {
+  return false;
+}
+
+int64_t PlatformInterface::host_vector_fp_kernel(
+  [[maybe_unused]] int64_t op,
+  [[maybe_unused]] int64_t sew,
+  [[maybe_unused]] uint64_t rm,
+  [[maybe_unused]] int64_t vd,
+  [[maybe_unused]] int64_t vs2,
+  [[maybe_unused]] int64_t vs1,
+  [[maybe_unused]] bool use_scalar,
+  [[maybe_unused]] uint64_t scalar,
+  [[maybe_unused]] bool masked,
+  [[maybe_unused]] int64_t start,
+  [[maybe_unused]] int64_t end
+) {
+  return -1;
+}
+
+unit PlatformInterface::checkpoint_bits(lbits *rop, [[maybe_unused]] const_sail_string name, lbits value) {
+  rop->len = value.len;
+  mpz_set(*rop->bits, *value.bits);
+  return UNIT;
+}
+
 unit PlatformInterface::load_reservation(sbits, uint64_t) {
   return UNIT;
 }
@@ -154,6 +280,27 @@ bool PlatformInterface::valid_reservation(unit) {
   return false;
 }
 
+uint64_t PlatformInterface::clint_remote_read(
+  [[maybe_unused]] uint64_t hart,
+  [[maybe_unused]] uint64_t offset,
+  [[maybe_unused]] int64_t width
+) {
+  return 0;
+}
+
+unit PlatformInterface::clint_remote_write(
+  [[maybe_unused]] uint64_t hart,
+  [[maybe_unused]] uint64_t offset,
+  [[maybe_unused]] int64_t width,
+  [[maybe_unused]] uint64_t value
+) {
+  return UNIT;
+}
+
+unit PlatformInterface::clint_mtime_written([[maybe_unused]] uint64_t mtime) {
+  return UNIT;
+}
+
 unit PlatformInterface::plat_term_write(mach_bits) {
   return UNIT;
 }
@@ -173,9 +320,13 @@ unit PlatformInterface::print_log(const_sail_string s) {
   return UNIT;
 }
 
-unit PlatformInterface::print_log_instr(const_sail_string s, uint64_t pc) {
-  (void)s;
-  (void)pc;
+unit PlatformInterface::print_log_instr(
+  [[maybe_unused]] uint64_t step,
+  [[maybe_unused]] const_sail_string privilege,
+  [[maybe_unused]] sbits pc,
+  [[maybe_unused]] sbits opcode,
+  [[maybe_unused]] const_sail_string disassembly
+) {
   return UNIT;
 }
 
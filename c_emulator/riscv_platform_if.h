@@ -42,6 +42,8 @@ public:
 
   virtual unit csr_full_read_callback(const_sail_string csr_name, unsigned reg, sbits value);
 
+  virtual bool csr_callbacks_enabled(unit);
+
   virtual unit vreg_write_callback(unsigned reg, lbits value);
 
   virtual unit pc_write_callback(sbits new_pc);
@@ -62,27 +64,92 @@ public:
   virtual unit ptw_success_callback(uint64_t final_ppn, int64_t level);
   virtual unit ptw_fail_callback(hart::zPTW_Error error_type, int64_t level, sbits pte_addr);
 
-  virtual unit tlb_add_callback(hart::zz5vecz8z5unionz0zzoptionzzIRTLB_EntryzzKz9 tlb, uint64_t index);
+  virtual unit tlb_add_callback(uint64_t index, hart::zTLB_Entry entry);
   virtual unit tlb_flush_begin_callback(unit);
-  virtual unit tlb_flush_callback(uint64_t index);
-  virtual unit tlb_flush_end_callback(hart::zz5vecz8z5unionz0zzoptionzzIRTLB_EntryzzKz9 tlb);
+  virtual unit tlb_flush_callback(uint64_t index, hart::zTLB_Entry entry);
+  virtual unit tlb_flush_end_callback(unit);
 
   // Provides entropy for the scalar cryptography extension.
   virtual mach_bits plat_get_16_random_bits(unit);
 
+  // Main memory held in host buffers. `host_ram_read` and `host_ram_write`
+  // are for accesses of up to 8 bytes, and the `_wide` variants for larger
+  // ones. `host_ram_read_wide` returns its result via `data`, as for all
+  // Sail functions returning large bitvectors.
+  virtual bool host_ram_contains(sbits paddr, int64_t width);
+  virtual sbits host_ram_read(sbits paddr, int64_t width);
+  virtual unit host_ram_write(sbits paddr, int64_t width, sbits value);
+  virtual unit host_ram_read_wide(lbits *data, sbits paddr, int64_t width);
+  virtual unit host_ram_write_wide(sbits paddr, int64_t width, lbits value);
+
+  // Vector registers held in host buffers, used while `host_vregs_enabled`
+  // returns true. `host_vreg_read` returns its result via `data`.
+  virtual bool host_vregs_enabled(unit);
+  virtual unit host_vreg_read(lbits *data, int64_t reg);
+  virtual unit host_vreg_write(int64_t reg, lbits value);
+  virtual sbits host_vreg_read_element(int64_t reg, int64_t sew, int64_t offset);
+  virtual unit host_vreg_write_element(int64_t reg, int64_t sew, int64_t offset, sbits value);
+  virtual unit host_vreg_written(int64_t reg);
+  // Unit-stride accesses copied between host RAM and the host registers.
+  virtual bool host_vreg_bulk_enabled(unit);
+  virtual unit host_vreg_load(int64_t reg, sbits paddr, int64_t width);
+  virtual unit host_vreg_store(int64_t reg, sbits paddr, int64_t width, int64_t eew_bytes);
+  // Element-wise arithmetic on the host registers. `op` is the number of a
+  // Sail `vector_kernel_op`.
+  virtual bool host_vector_int_kernel(
+    int64_t op,
+    int64_t sew,
+    int64_t vd,
+    int64_t vs2,
+    int64_t vs1,
+    bool use_scalar,
+    uint64_t scalar,
+    bool masked,
+    int64_t start,
+    int64_t end
+  );
+  virtual int64_t host_vector_fp_kernel(
+    int64_t op,
+    int64_t sew,
+    uint64_t rm,
+    int64_t vd,
+    int64_t vs2,
+    int64_t vs1,
+    bool use_scalar,
+    uint64_t scalar,
+    bool masked,
+    int64_t start,
+    int64_t end
+  );
+
+  // Passes model state through the emulator when saving or restoring a
+  // checkpoint. The result is returned via `rop`.
+  virtual unit checkpoint_bits(lbits *rop, const_sail_string name, lbits value);
+
   virtual unit load_reservation(sbits, uint64_t);
   virtual bool match_reservation(sbits);
   virtual unit cancel_reservation(unit);
 
   virtual bool valid_reservation(unit);
 
+  // Accesses to the CLINT registers of other harts, and writes to mtime.
+  virtual uint64_t clint_remote_read(uint64_t hart, uint64_t offset, int64_t width);
+  virtual unit clint_remote_write(uint64_t hart, uint64_t offset, int64_t width, uint64_t value);
+  virtual unit clint_mtime_written(uint64_t mtime);
+
   virtual unit plat_term_write(mach_bits);
 
   virtual bool sys_enable_experimental_extensions(unit);
 
   virtual unit print_string(const_sail_string prefix, const_sail_string msg);
   virtual unit print_log(const_sail_string s);
-  virtual unit print_log_instr(const_sail_string s, uint64_t pc);
+  virtual unit print_log_instr(
+    uint64_t step,
+    const_sail_string privilege,
+    sbits pc,
+    sbits opcode,
+    const_sail_string disassembly
+  );
   virtual unit print_step(unit);
 
   virtual bool get_config_print_instr(unit);
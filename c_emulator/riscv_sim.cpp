@@ -1,14 +1,18 @@
 #include "riscv_sim.h"
 #include "CLI11.hpp"
+#include "checkpoint.h"
 #include "cli_options.h"
 #include "config_utils.h"
 #include "elf_loader.h"
 #include "file_utils.h"
 #include "jsoncons/config/version.hpp"
 #include "jsoncons/json.hpp"
+#include "riscv_callbacks_profile.h"
 #include "riscv_callbacks_rvfi.h"
+#include "riscv_callbacks_stats.h"
 #include "riscv_callbacks_stop_at_pc.h"
 #include "riscv_model_impl.h"
+#include "riscv_softfloat.h"
 #ifdef SAILCOV
 #include "sail_coverage.h"
 #endif
@@ -16,9 +20,12 @@
 #include "sail_riscv_version.h"
 #include "symbol_table.h"
 #include "traploop_detector.h"
+#include "vector_kernels.h"
 
+#include <algorithm>
 #include <asio.hpp>
 #include <fcntl.h>
+#include <limits>
 
 using std::chrono::duration_cast;
 using std::chrono::milliseconds;
@@ -89,11 +96,16 @@ void write_dtb_to_rom(ModelImpl &model, const std::vector<uint8_t> &dtb) {
   }
 
   for (uint8_t d : dtb) {
-    write_mem(addr++, d);
+    model.write_mem_byte(addr++, d);
   }
 }
 
-void write_signature(const std::string &file, unsigned signature_granularity, const elf_info &elf_info) {
+void write_signature(
+  ModelImpl &model,
+  const std::string &file,
+  unsigned signature_granularity,
+  const elf_info &elf_info
+) {
   if (elf_info.mem_sig_start >= elf_info.mem_sig_end) {
     fprintf(
       stderr,
@@ -113,7 +125,7 @@ void write_signature(const std::string &file, unsigned signature_granularity, co
   for (uint64_t addr = elf_info.mem_sig_start; addr < elf_info.mem_sig_end; addr += signature_granularity) {
     /* most-significant byte first */
     for (unsigned i = signature_granularity; i > 0; --i) {
-      uint8_t byte = static_cast<uint8_t>(read_mem(addr + i - 1));
+      uint8_t byte = model.read_mem_byte(addr + i - 1);
       fprintf(f, "%02x", byte);
     }
     fprintf(f, "\n");
@@ -121,7 +133,7 @@ void write_signature(const std::string &file, unsigned signature_granularity, co
   fclose(f);
 }
 
-void write_memory_dump(const MemoryRegion &region, const std::string &prefix) {
+void write_memory_dump(ModelImpl &model, const MemoryRegion &region, const std::string &prefix) {
   std::ostringstream file_os;
   file_os << prefix << ".0x" << std::hex << region.base << ".bin";
   const std::string file = file_os.str();
@@ -140,9 +152,7 @@ void write_memory_dump(const MemoryRegion &region, const std::string &prefix) {
   uint64_t offset = 0;
   while (offset < region.size) {
     size_t chunk = static_cast<size_t>(std::min<uint64_t>(buffer.size(), region.size - offset));
-    for (size_t i = 0; i < chunk; ++i) {
-      buffer[i] = static_cast<uint8_t>(read_mem(region.base + offset + i));
-    }
+    model.read_mem_bytes(region.base + offset, buffer.data(), chunk);
     if (fwrite(buffer.data(), 1, chunk, f) != chunk) {
       fprintf(stderr, "Could not write memory dump '%s': %s\n", file.c_str(), strerror(errno));
       break;
@@ -153,9 +163,26 @@ void write_memory_dump(const MemoryRegion &region, const std::string &prefix) {
   fclose(f);
 }
 
-void write_memory_dumps(const std::vector<MemoryRegion> &regions, const std::string &prefix) {
-  for (const auto &region : regions) {
-    write_memory_dump(region, prefix);
+// Options that are set on the model of every hart.
+void set_model_options(const CLIOptions &opts, ModelImpl &model, const run_info &run_info) {
+  model.set_enable_experimental_extensions(opts.config_enable_experimental_extensions);
+  model.set_host_vregs(!opts.no_host_vregs);
+
+  model.set_config_print_instr(opts.config_print_instr);
+  model.set_config_print_clint(opts.config_print_clint);
+  model.set_config_print_exception(opts.config_print_exception);
+  model.set_config_print_interrupt(opts.config_print_interrupt);
+  model.set_config_print_htif(opts.config_print_htif);
+  model.set_config_print_pma(opts.config_print_pma);
+  model.set_config_rvfi(run_info.rvfi.has_value());
+  model.set_config_use_abi_names(opts.config_use_abi_names);
+
+  model.set_config_print_step(opts.config_print_step);
+}
+
+void write_memory_dumps(ModelImpl &model, const std::string &prefix) {
+  for (const auto &region : model.main_memory_regions()) {
+    write_memory_dump(model, region, prefix);
   }
 }
 
@@ -180,22 +207,21 @@ uint64_t load_sail(ModelImpl &model, const std::string &filename, bool main_file
   }
 
   // Load into memory.
-  elf.load([](uint64_t address, const uint8_t *data, uint64_t length) {
-    // TODO: We could definitely improve on rts.c's memory implementation
-    // (which is O(N^2)) and writing one byte at a time here.
-    for (uint64_t i = 0; i < length; ++i) {
-      write_mem(address + i, data[i]);
-    }
-  });
+  elf.load(
+    [&model](uint64_t address, const uint8_t *data, uint64_t length) {
+      model.write_mem_bytes(address, data, length);
+    },
+    [&model](uint64_t address, uint64_t length) { model.zero_mem_bytes(address, length); }
+  );
 
   // Load the entire symbol table.
   const auto symbols = elf.symbols();
 
-  // Save reversed symbol table for log symbolization.
-  // If multiple symbols from different ELF files have the same value the first
-  // one wins.
-  const auto reversed_symbols = reverse_symbol_table(symbols);
-  elf_info.symbols.insert(reversed_symbols.begin(), reversed_symbols.end());
+  // Save the symbols for symbolization. If multiple symbols from different
+  // ELF files have the same value the first one wins.
+  for (const auto &[name, symbol] : symbols) {
+    elf_info.symbols.push_back({name, symbol.value, symbol.size});
+  }
 
   if (main_file) {
     // Only scan for test-signature/htif symbols in the main ELF file.
@@ -205,19 +231,19 @@ uint64_t load_sail(ModelImpl &model, const std::string &filename, bool main_file
       fprintf(stderr, "Unable to locate tohost symbol; disabling HTIF.\n");
       elf_info.htif_tohost_address = std::nullopt;
     } else {
-      elf_info.htif_tohost_address = tohost->second;
+      elf_info.htif_tohost_address = tohost->second.value;
       fprintf(stdout, "HTIF located at 0x%0" PRIx64 "\n", *elf_info.htif_tohost_address);
     }
     // Locate test-signature locations if any.
     const auto &begin_sig = symbols.find("begin_signature");
     if (begin_sig != symbols.end()) {
-      fprintf(stdout, "begin_signature: 0x%0" PRIx64 "\n", begin_sig->second);
-      elf_info.mem_sig_start = begin_sig->second;
+      fprintf(stdout, "begin_signature: 0x%0" PRIx64 "\n", begin_sig->second.value);
+      elf_info.mem_sig_start = begin_sig->second.value;
     }
     const auto &end_sig = symbols.find("end_signature");
     if (end_sig != symbols.end()) {
-      fprintf(stdout, "end_signature: 0x%0" PRIx64 "\n", end_sig->second);
-      elf_info.mem_sig_end = end_sig->second;
+      fprintf(stdout, "end_signature: 0x%0" PRIx64 "\n", end_sig->second.value);
+      elf_info.mem_sig_end = end_sig->second.value;
     }
   }
 
@@ -231,6 +257,15 @@ void close_logs(run_info &run_info) {
   if (run_info.trace_log != stdout) {
     fclose(run_info.trace_log);
   }
+  if (run_info.binary_trace) {
+    run_info.binary_trace->close();
+  }
+  if (run_info.profiler && !run_info.profiler->write(run_info.profile_path)) {
+    fprintf(stderr, "Cannot write profile '%s': %s\n", run_info.profile_path.c_str(), strerror(errno));
+  }
+  if (run_info.stats && !run_info.stats->write(run_info.stats_path)) {
+    fprintf(stderr, "Cannot write statistics '%s': %s\n", run_info.stats_path.c_str(), strerror(errno));
+  }
 #ifdef SAILCOV
   if (sail_coverage_exit() != 0) {
     fprintf(stderr, "Could not write coverage information!\n");
@@ -239,29 +274,123 @@ void close_logs(run_info &run_info) {
 #endif
 }
 
-void finish(ModelImpl &model, const CLIOptions &opts, const elf_info &elf_info, run_info &run_info) {
+namespace {
+
+// Statistics held in model registers, which must be read before the model
+// is finalized.
+struct hart_counters {
+  uint64_t decode_hits = 0;
+  uint64_t decode_misses = 0;
+  uint64_t tlb_hits = 0;
+  uint64_t tlb_misses = 0;
+  uint64_t walk_cache_hits = 0;
+  uint64_t walk_cache_misses = 0;
+
+  explicit hart_counters(ModelImpl &model)
+      : decode_hits(model.decode_cache_hits()),
+        decode_misses(model.decode_cache_misses()),
+        tlb_hits(model.tlb_hits()),
+        tlb_misses(model.tlb_misses()),
+        walk_cache_hits(model.walk_cache_hits()),
+        walk_cache_misses(model.walk_cache_misses()) {
+  }
+};
+
+void print_hit_rate(const char *label, uint64_t hits, uint64_t misses) {
+  uint64_t lookups = hits + misses;
+  fprintf(
+    stderr,
+    "%-18s%" PRIu64 " hits, %" PRIu64 " misses (%.2f%% hit rate)\n",
+    label,
+    hits,
+    misses,
+    lookups == 0 ? 0.0 : 100.0 * static_cast<double>(hits) / static_cast<double>(lookups)
+  );
+}
+
+// Print the total over all harts and, if there are several, each hart's
+// own hits and misses.
+void print_hit_rates(
+  const char *label,
+  const std::vector<hart_counters> &counters,
+  uint64_t hart_counters::*hits,
+  uint64_t hart_counters::*misses
+) {
+  uint64_t total_hits = 0;
+  uint64_t total_misses = 0;
+  for (const auto &c : counters) {
+    total_hits += c.*hits;
+    total_misses += c.*misses;
+  }
+  print_hit_rate(label, total_hits, total_misses);
+  if (counters.size() > 1) {
+    for (size_t i = 0; i < counters.size(); i++) {
+      const std::string hart_label = "  hart " + std::to_string(i) + ":";
+      print_hit_rate(hart_label.c_str(), counters[i].*hits, counters[i].*misses);
+    }
+  }
+}
+
+} // namespace
+
+void finish(const std::vector<ModelImpl *> &models, const CLIOptions &opts, const elf_info &elf_info, run_info &run_info) {
+  ModelImpl &model = *models[0];
+  const bool had_exception = std::any_of(models.begin(), models.end(), [](ModelImpl *m) {
+    return m->had_exception();
+  });
+
   // Don't write a signature if there was an internal Sail exception.
-  if (!model.had_exception() && !opts.sig_file.empty()) {
-    write_signature(opts.sig_file, opts.signature_granularity, elf_info);
+  if (!had_exception && !opts.sig_file.empty()) {
+    write_signature(model, opts.sig_file, opts.signature_granularity, elf_info);
   }
   if (!opts.dump_memory_prefix.empty()) {
-    write_memory_dumps(model.main_memory_regions(), opts.dump_memory_prefix);
+    write_memory_dumps(model, opts.dump_memory_prefix);
+  }
+
+  if (!had_exception && !opts.save_checkpoint_file.empty()) {
+    fprintf(
+      stdout,
+      "Saving checkpoint to %s after %" PRIu64 " instructions.\n",
+      opts.save_checkpoint_file.c_str(),
+      run_info.total_insns
+    );
+    save_checkpoint(model, opts.save_checkpoint_file, run_info.total_insns);
+  }
+
+  std::vector<hart_counters> counters;
+  for (ModelImpl *hart : models) {
+    counters.emplace_back(*hart);
   }
 
   // `model_fini()` exits with failure if there was a Sail exception.
-  model.model_fini();
+  for (ModelImpl *hart : models) {
+    hart->model_fini();
+  }
 
   if (opts.do_show_times) {
     auto run_end = steady_clock::now();
     uint64_t init_msecs = duration_cast<milliseconds>(run_info.init_end - run_info.init_start).count();
+    uint64_t load_msecs = duration_cast<milliseconds>(run_info.elf_load_time).count();
     uint64_t exec_msecs = duration_cast<milliseconds>(run_end - run_info.init_end).count();
+    uint64_t exec_insns = run_info.total_insns - run_info.restored_insns;
     fprintf(stderr, "Initialization:   %" PRIu64 " ms\n", init_msecs);
+    fprintf(stderr, "  ELF loading:    %" PRIu64 " ms\n", load_msecs);
     fprintf(stderr, "Execution:        %" PRIu64 " ms\n", exec_msecs);
-    fprintf(stderr, "Instructions:     %" PRIu64 "\n", run_info.total_insns);
-    fprintf(stderr, "Performance:      %" PRIu64 " kIPS\n", exec_msecs == 0 ? 0 : run_info.total_insns / exec_msecs);
+    fprintf(stderr, "Instructions:     %" PRIu64 "\n", exec_insns);
+    if (run_info.hart_insns.size() > 1) {
+      for (size_t i = 0; i < run_info.hart_insns.size(); i++) {
+        const std::string hart_label = "  hart " + std::to_string(i) + ":";
+        fprintf(stderr, "%-18s%" PRIu64 "\n", hart_label.c_str(), run_info.hart_insns[i]);
+      }
+    }
+    fprintf(stderr, "Performance:      %" PRIu64 " kIPS\n", exec_msecs == 0 ? 0 : exec_insns / exec_msecs);
+    print_hit_rates("Decode cache:", counters, &hart_counters::decode_hits, &hart_counters::decode_misses);
+    print_hit_rates("TLB:", counters, &hart_counters::tlb_hits, &hart_counters::tlb_misses);
+    print_hit_rates("Walk cache:", counters, &hart_counters::walk_cache_hits, &hart_counters::walk_cache_misses);
+    fprintf(stderr, "Vector kernels:   %s\n", vector_kernel_isa());
   }
   close_logs(run_info);
-  exit(model.had_exception() ? EXIT_FAILURE : EXIT_SUCCESS);
+  exit(had_exception ? EXIT_FAILURE : EXIT_SUCCESS);
 }
 
 void flush_logs(run_info &run_info) {
@@ -270,29 +399,71 @@ void flush_logs(run_info &run_info) {
   fflush(run_info.trace_log);
 }
 
+namespace {
+
+// Scheduling state of a hart in run_sail().
+struct hart_state {
+  ModelImpl *model = nullptr;
+  traploop_detector *loop_detector = nullptr;
+  bool is_waiting = false;
+  uint64_t wait_steps_remaining = 0;
+  mach_int step_no = 0;
+};
+
+} // namespace
+
 void run_sail(
-  ModelImpl &model,
+  const std::vector<ModelImpl *> &models,
   const CLIOptions &opts,
-  std::shared_ptr<traploop_detector> loop_detector,
+  const std::vector<std::shared_ptr<traploop_detector>> &loop_detectors,
   std::shared_ptr<stop_at_pc_callbacks> stop_at_pc,
   const elf_info &elf_info,
   run_info &run_info
 ) {
-  bool is_waiting = false;
   // The emulator tick increments time by 1 at every step, so the number
   // of steps to wait is equal to the needed increment in the time CSR.
   uint64_t max_wait_steps = get_config_uint64({"platform", "max_time_to_wait"});
-  uint64_t wait_steps_remaining = 0;
-
-  /* initialize the step number */
-  mach_int step_no = 0;
-  uint64_t insn_cnt = 0;
+  // Skipping wait steps would drop the per-tick clint trace and the RVFI
+  // handshakes, so only do it when neither is in use.
+  const bool fast_forward_wait = get_config_bool({"platform", "fast_forward_wait"}) && !opts.config_print_clint &&
+                                 !run_info.rvfi.has_value();
 
   uint64_t insns_per_tick = get_config_uint64({"platform", "instructions_per_tick"});
 
+  // When nothing needs doing between the steps of an active hart, run it
+  // in bursts inside the model instead of one step per iteration below.
+  const bool use_model_run = !opts.single_step_loop && models.size() == 1 && !run_info.rvfi.has_value() &&
+                             !opts.config_print_instr && !opts.config_print_step;
+
+  // The harts take turns to run `quantum` steps each. Time is shared: it
+  // advances with the steps of all the harts, by one tick for every
+  // `insns_per_tick` instructions that each of them retires, and is
+  // ticked on all of them together. A waiting step counts as a tick's
+  // worth of instructions, as a waiting hart ticks the clock every step.
+  const uint64_t quantum = get_config_uint64({"platform", "hart_quantum"});
+  std::vector<hart_state> harts(models.size());
+  for (size_t i = 0; i < models.size(); i++) {
+    harts[i].model = models[i];
+    harts[i].loop_detector = loop_detectors[i].get();
+  }
+  size_t current = 0;
+  uint64_t quantum_remaining = quantum;
+  const uint64_t insns_per_platform_tick = insns_per_tick * harts.size();
+
+  const auto tick_clock = [&harts]() {
+    for (const hart_state &hart : harts) {
+      hart.model->tick_clock();
+    }
+  };
+
+  /* initialize the step number, continuing from a restored checkpoint */
+  harts[0].step_no = static_cast<mach_int>(run_info.restored_insns);
+  uint64_t insn_cnt = run_info.restored_insns % insns_per_tick;
+
   auto interval_start = steady_clock::now();
 
-  while (!model.htif_done() && !(stop_at_pc && stop_at_pc->stop_requested()) &&
+  bool htif_done = false;
+  while (!htif_done && !(stop_at_pc && stop_at_pc->stop_requested()) &&
          (opts.insn_limit == 0 || run_info.total_insns < opts.insn_limit)) {
     if (run_info.rvfi.has_value()) {
       switch (run_info.rvfi->pre_step(opts.config_print_rvfi)) {
@@ -308,42 +479,75 @@ void run_sail(
       }
     }
 
-    model.call_pre_step_callbacks(is_waiting);
-
-    { /* run a Sail step */
-      is_waiting = model.try_step(step_no, wait_steps_remaining == 0);
+    if (quantum_remaining == 0) {
+      current = (current + 1) % harts.size();
+      quantum_remaining = quantum;
+    }
+    quantum_remaining--;
+    hart_state &hart = harts[current];
+    ModelImpl &model = *hart.model;
+
+    if (use_model_run && !hart.is_waiting) {
+      // Stop the burst where the loop condition or the kips report below
+      // need to see it. The clock is ticked inside the burst.
+      uint64_t max_steps = std::numeric_limits<uint64_t>::max();
+      if (opts.insn_limit != 0) {
+        max_steps = opts.insn_limit - run_info.total_insns;
+      }
+      if (opts.do_show_times) {
+        max_steps = std::min<uint64_t>(max_steps, 0x100000 - (run_info.total_insns & 0xfffff));
+      }
+      const ModelImpl::RunResult result = model.run(max_steps, hart.step_no, insns_per_tick, insn_cnt);
+      hart.step_no += static_cast<mach_int>(result.steps);
+      run_info.total_insns += result.steps;
 
-      std::optional<std::string> opt_str = model.string_of_current_exception();
-      if (opt_str.has_value()) {
-        fprintf(stdout, "%s\n", opt_str.value().c_str());
+      if (result.reason == ModelImpl::RunStop::exception) {
+        fprintf(stdout, "%s\n", model.string_of_current_exception().value().c_str());
         break;
       }
-      if (opts.config_print_instr) {
-        flush_logs(run_info);
+      if (result.reason == ModelImpl::RunStop::waiting) {
+        // The rest of this iteration handles the step that started the wait.
+        hart.is_waiting = true;
+        hart.wait_steps_remaining = max_wait_steps;
       }
-      if (run_info.rvfi) {
-        run_info.rvfi->send_trace(opts.config_print_rvfi);
-      }
-      if (is_waiting) {
-        if (wait_steps_remaining == 0) {
-          wait_steps_remaining = max_wait_steps;
+    } else {
+      model.call_pre_step_callbacks(hart.is_waiting);
+
+      { /* run a Sail step */
+        hart.is_waiting = model.try_step(hart.step_no, hart.wait_steps_remaining == 0);
+
+        std::optional<std::string> opt_str = model.string_of_current_exception();
+        if (opt_str.has_value()) {
+          fprintf(stdout, "%s\n", opt_str.value().c_str());
+          break;
+        }
+        if (opts.config_print_instr) {
+          flush_logs(run_info);
+        }
+        if (run_info.rvfi) {
+          run_info.rvfi->send_trace(opts.config_print_rvfi);
+        }
+        if (hart.is_waiting) {
+          if (hart.wait_steps_remaining == 0) {
+            hart.wait_steps_remaining = max_wait_steps;
+          } else {
+            --hart.wait_steps_remaining;
+          }
         } else {
-          --wait_steps_remaining;
+          hart.wait_steps_remaining = 0;
         }
-      } else {
-        wait_steps_remaining = 0;
       }
-    }
 
-    model.call_post_step_callbacks(is_waiting);
+      model.call_post_step_callbacks(hart.is_waiting);
 
-    if (!is_waiting) {
-      if (opts.config_print_step) {
-        fprintf(run_info.trace_log, "\n");
+      if (!hart.is_waiting) {
+        if (opts.config_print_step) {
+          run_info.trace->text("\n");
+        }
+        hart.step_no++;
+        insn_cnt++;
+        run_info.total_insns++;
       }
-      step_no++;
-      insn_cnt++;
-      run_info.total_insns++;
     }
 
     if (opts.do_show_times && (run_info.total_insns & 0xfffff) == 0) {
@@ -355,29 +559,60 @@ void run_sail(
       fprintf(stdout, "kips: %" PRIu64 "\n", kips);
     }
 
-    if (model.htif_done()) {
-      /* check exit code */
-      if (model.htif_exit_code() == 0) {
-        fprintf(stdout, "SUCCESS\n");
-      } else {
-        fprintf(stdout, "FAILURE: %" PRIu64 " (0x%08" PRIx64 ")\n", model.htif_exit_code(), model.htif_exit_code());
-        exit(EXIT_FAILURE);
+    // Any hart can end the run through HTIF, including one that another
+    // hart's step acted on.
+    for (const hart_state &other : harts) {
+      if (other.model->htif_done()) {
+        htif_done = true;
+        /* check exit code */
+        const uint64_t exit_code = other.model->htif_exit_code();
+        if (exit_code == 0) {
+          fprintf(stdout, "SUCCESS\n");
+        } else {
+          fprintf(stdout, "FAILURE: %" PRIu64 " (0x%08" PRIx64 ")\n", exit_code, exit_code);
+          exit(EXIT_FAILURE);
+        }
+        break;
       }
     }
 
-    if (insn_cnt == insns_per_tick) {
-      insn_cnt = 0;
-      model.tick_clock();
-    } else if (wait_steps_remaining > 0) {
-      model.tick_clock();
+    if (hart.wait_steps_remaining > 0) {
+      insn_cnt += insns_per_tick;
+    }
+    if (insn_cnt >= insns_per_platform_tick) {
+      insn_cnt -= insns_per_platform_tick;
+      tick_clock();
+    }
+
+    // Each further step of this wait would only tick the clock, until
+    // either the timer interrupt bits change or a wait expires, so do
+    // those ticks at once. The last tick before the first expiry is not
+    // taken, as in the loop above. Every hart must be waiting, as they
+    // all see the time, and each of their waits is shortened by the
+    // ticks skipped.
+    if (fast_forward_wait && hart.wait_steps_remaining > 1) {
+      uint64_t ticks = std::numeric_limits<uint64_t>::max();
+      for (const hart_state &other : harts) {
+        if (!other.is_waiting || other.wait_steps_remaining <= 1) {
+          ticks = 0;
+          break;
+        }
+        ticks = std::min({ticks, other.wait_steps_remaining - 1, other.model->ticks_until_timer_change()});
+      }
+      if (ticks > 0) {
+        for (hart_state &other : harts) {
+          other.model->fast_forward_clock(ticks);
+          other.wait_steps_remaining -= ticks;
+        }
+      }
     }
 
-    if (loop_detector->loop_detected()) {
+    if (hart.loop_detector->loop_detected()) {
       fprintf(
         stdout,
         "FAILURE: possible trap loop detected with MEPC=0x%" PRIx64 " and SEPC=0x%" PRIx64 "\n",
-        loop_detector->mepc(),
-        loop_detector->sepc()
+        hart.loop_detector->mepc(),
+        hart.loop_detector->sepc()
       );
       exit(EXIT_FAILURE);
     }
@@ -385,7 +620,10 @@ void run_sail(
 
   // This is reached if there is a Sail exception, HTIF has indicated
   // successful completion, or the instruction limit has been reached.
-  finish(model, opts, elf_info, run_info);
+  for (const hart_state &hart : harts) {
+    run_info.hart_insns.push_back(static_cast<uint64_t>(hart.step_no));
+  }
+  finish(models, opts, elf_info, run_info);
 }
 
 void init_logs(const CLIOptions &opts, run_info &run_info) {
@@ -398,13 +636,21 @@ void init_logs(const CLIOptions &opts, run_info &run_info) {
     run_info.close_term_fd = true;
   }
 
-  if (!opts.trace_log_path.empty()) {
+  if (opts.trace_format == "binary") {
+    run_info.binary_trace = std::make_unique<BinaryTraceWriter>(opts.trace_log_path, opts.trace_compress);
+  } else if (!opts.trace_log_path.empty()) {
     run_info.trace_log = fopen(opts.trace_log_path.c_str(), "w+");
     if (run_info.trace_log == nullptr) {
       fprintf(stderr, "Cannot create trace log '%s': %s\n", opts.trace_log_path.c_str(), strerror(errno));
       exit(EXIT_FAILURE);
     }
   }
+  if (run_info.binary_trace) {
+    run_info.trace = run_info.binary_trace.get();
+  } else {
+    run_info.text_trace = std::make_unique<TextTraceSink>(run_info.trace_log);
+    run_info.trace = run_info.text_trace.get();
+  }
 
 #ifdef SAILCOV
   if (!opts.sailcov_file.empty()) {
@@ -446,9 +692,27 @@ InitResult preinit_args(CLIOptions &opts, std::string &config_json_string) {
   if (opts.signature_granularity != DEFAULT_SIGNATURE_GRANULARITY) {
     fprintf(stderr, "setting signature-granularity to %d bytes\n", opts.signature_granularity);
   }
+  if (opts.trace_format == "binary" && opts.trace_log_path.empty()) {
+    fprintf(stderr, "--trace-format binary requires --trace-output.\n");
+    return InitResult::ExitFailure;
+  }
+  if (opts.trace_compress && opts.trace_format != "binary") {
+    fprintf(stderr, "--trace-compress requires --trace-format binary.\n");
+    return InitResult::ExitFailure;
+  }
   if (!opts.trace_log_path.empty()) {
     fprintf(stderr, "using %s for trace output.\n", opts.trace_log_path.c_str());
   }
+  if (!opts.profile_path.empty()) {
+    fprintf(stderr, "using %s for profile output.\n", opts.profile_path.c_str());
+  }
+  if (!opts.stats_json_path.empty()) {
+    fprintf(stderr, "using %s for statistics output.\n", opts.stats_json_path.c_str());
+  }
+  if (opts.host_fpu && !softfloat_use_host_fpu(true)) {
+    fprintf(stderr, "--host-fpu is not supported on this host.\n");
+    return InitResult::ExitFailure;
+  }
   if (!opts.dump_memory_prefix.empty()) {
     fprintf(stderr, "will dump main memory on completion using prefix '%s'.\n", opts.dump_memory_prefix.c_str());
   }
@@ -501,21 +765,11 @@ InitResult preinit_model(
 
   if (opts.config_enable_experimental_extensions) {
     fprintf(stderr, "enabling unratified extensions.\n");
-    model.set_enable_experimental_extensions(true);
   }
 
   // Initialize the model.
 
-  model.set_config_print_instr(opts.config_print_instr);
-  model.set_config_print_clint(opts.config_print_clint);
-  model.set_config_print_exception(opts.config_print_exception);
-  model.set_config_print_interrupt(opts.config_print_interrupt);
-  model.set_config_print_htif(opts.config_print_htif);
-  model.set_config_print_pma(opts.config_print_pma);
-  model.set_config_rvfi(run_info.rvfi.has_value());
-  model.set_config_use_abi_names(opts.config_use_abi_names);
-
-  model.set_config_print_step(opts.config_print_step);
+  set_model_options(opts, model, run_info);
 
   sail_config_set_string(config_json_string.c_str());
 
@@ -560,9 +814,25 @@ InitResult preinit_model(
     return InitResult::ExitFailure;
   }
 
+  // These only handle the first hart.
+  if (get_config_uint64({"platform", "harts"}) > 1) {
+    if (run_info.rvfi.has_value() || opts.gdb_server_port != 0) {
+      fprintf(stderr, "RVFI and the GDB server require a single hart.\n");
+      return InitResult::ExitFailure;
+    }
+    if (!opts.save_checkpoint_file.empty() || !opts.restore_checkpoint_file.empty()) {
+      fprintf(stderr, "Checkpoints require a single hart.\n");
+      return InitResult::ExitFailure;
+    }
+  }
+
+  // Main memory is mapped lazily by the host, so this is cheap even for
+  // large regions.
+  model.init_host_memory();
+
   init_logs(opts, run_info);
   model.set_term_fd(run_info.term_fd);
-  model.set_trace_log(run_info.trace_log);
+  model.set_trace(run_info.trace);
 
   return InitResult::Continue;
 }
@@ -582,8 +852,10 @@ uint64_t init_model(CLIOptions &opts, ModelImpl &model, elf_info &elf_info, run_
     write_dtb_to_rom(model, read_file(opts.dtb_file));
   }
 
+  auto load_start = steady_clock::now();
   uint64_t entry = run_info.rvfi.has_value() ? rvfi_handler::get_entry()
                                              : load_sail(model, opts.elfs[0], /*main_file=*/true, elf_info);
+  run_info.elf_load_time += steady_clock::now() - load_start;
 
   fprintf(stdout, "Entry point: 0x%" PRIx64 "\n", entry);
 
@@ -591,11 +863,41 @@ uint64_t init_model(CLIOptions &opts, ModelImpl &model, elf_info &elf_info, run_
   // the first one because it was loaded above.
   for (auto it = opts.elfs.cbegin() + (run_info.rvfi.has_value() ? 0 : 1); it != opts.elfs.cend(); it++) {
     fprintf(stdout, "Loading additional ELF file %s.\n", it->c_str());
+    load_start = steady_clock::now();
     (void)load_sail(model, *it, /*main_file=*/false, elf_info);
+    run_info.elf_load_time += steady_clock::now() - load_start;
+  }
+
+  // The other harts share memory with this one, and start at the same
+  // entry point.
+  run_info.harts = {&model};
+  const uint64_t num_harts = get_config_uint64({"platform", "harts"});
+  for (uint64_t index = 1; index < num_harts; index++) {
+    auto hart = std::make_unique<ModelImpl>();
+    set_model_options(opts, *hart, run_info);
+    hart->init_platform_constants();
+    hart->model_init();
+    hart->share_host_memory(model);
+    hart->set_term_fd(run_info.term_fd);
+    hart->set_trace(run_info.trace);
+    hart->set_elf_symbols(SymbolTable(elf_info.symbols));
+    hart->set_hart_index(index);
+    hart->init_sail(entry, opts.config_file.c_str(), elf_info.htif_tohost_address);
+    run_info.harts.push_back(hart.get());
+    run_info.secondary_harts.push_back(std::move(hart));
+  }
+
+  model.set_elf_symbols(SymbolTable(std::move(elf_info.symbols)));
+  model.init_sail(entry, opts.config_file.c_str(), elf_info.htif_tohost_address);
+  for (ModelImpl *hart : run_info.harts) {
+    hart->set_harts(run_info.harts);
   }
 
-  model.set_elf_symbols(std::move(elf_info.symbols));
-  model.init_sail(entry, opts.config_file.c_str(), elf_info.htif_tohost_address);
+  if (!opts.restore_checkpoint_file.empty()) {
+    fprintf(stdout, "Restoring checkpoint from %s.\n", opts.restore_checkpoint_file.c_str());
+    run_info.restored_insns = restore_checkpoint(model, opts.restore_checkpoint_file);
+    run_info.total_insns = run_info.restored_insns;
+  }
 
   run_info.init_end = steady_clock::now();
 
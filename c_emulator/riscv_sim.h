@@ -1,18 +1,23 @@
 #pragma once
 
+#include "binary_trace.h"
 #include "rvfi_dii.h"
+#include "symbol_table.h"
 
 #include <chrono>
-#include <map>
+#include <memory>
 #include <optional>
 #include <string>
 #include <unistd.h>
+#include <vector>
 
 using std::chrono::steady_clock;
 
 struct CLIOptions;
 class traploop_detector;
 class stop_at_pc_callbacks;
+class profile_callbacks;
+class stats_callbacks;
 class ModelImpl;
 
 struct elf_info {
@@ -20,7 +25,7 @@ struct elf_info {
   std::optional<uint64_t> htif_tohost_address = {};
   uint64_t mem_sig_start = 0;
   uint64_t mem_sig_end = 0;
-  std::map<uint64_t, std::string> symbols = {};
+  std::vector<Symbol> symbols = {};
 };
 
 struct run_info {
@@ -30,8 +35,32 @@ struct run_info {
   bool close_term_fd = false;
   steady_clock::time_point init_start = {};
   steady_clock::time_point init_end = {};
+  // Time spent reading ELF files and loading them into memory; part of
+  // the initialization time.
+  steady_clock::duration elf_load_time = {};
   uint64_t total_insns = 0;
+  // Instructions executed by each hart, set when the simulation stops.
+  std::vector<uint64_t> hart_insns = {};
+  // Instructions executed before the restored checkpoint, if any.
+  uint64_t restored_insns = 0;
   FILE *trace_log = stdout;
+  // Set instead of `trace_log` with `--trace-format binary`.
+  std::unique_ptr<BinaryTraceWriter> binary_trace = {};
+  // Writes text trace output to `trace_log` when there is no binary trace.
+  std::unique_ptr<TextTraceSink> text_trace = {};
+  // Where trace output goes: `binary_trace` or `text_trace`. Set by
+  // init_logs().
+  TraceSink *trace = nullptr;
+  // Set with `--profile`, and written to `profile_path` by close_logs().
+  std::shared_ptr<profile_callbacks> profiler = {};
+  std::string profile_path = {};
+  // Set with `--stats-json`, and written to `stats_path` by close_logs().
+  std::shared_ptr<stats_callbacks> stats = {};
+  std::string stats_path = {};
+  // All the harts of the platform in index order, starting with the model
+  // passed to init_model(). The others are owned by `secondary_harts`.
+  std::vector<ModelImpl *> harts = {};
+  std::vector<std::unique_ptr<ModelImpl>> secondary_harts = {};
 };
 
 // Initialization result used during startup.
@@ -53,21 +82,25 @@ InitResult preinit_args(CLIOptions &opts, std::string &config_json_string);
 // model simulation.
 InitResult preinit_model(CLIOptions &opts, ModelImpl &model, const std::string &config_json_string, run_info &run_info);
 
-// Returns the entry address.
+// Returns the entry address. Creates the other harts of the platform, if
+// there are several.
 uint64_t init_model(CLIOptions &opts, ModelImpl &model, elf_info &elf_info, run_info &run_info);
 
 uint64_t load_sail(ModelImpl &model, const std::string &filename, bool main_file, elf_info &elf_info);
 
+// Runs the harts in turn, with a trap loop detector for each.
 void run_sail(
-  ModelImpl &model,
+  const std::vector<ModelImpl *> &models,
   const CLIOptions &opts,
-  std::shared_ptr<traploop_detector> loop_detector,
+  const std::vector<std::shared_ptr<traploop_detector>> &loop_detectors,
   std::shared_ptr<stop_at_pc_callbacks> stop_at_pc,
   const elf_info &elf_info,
   run_info &run_info
 );
 
-void finish(ModelImpl &model, const CLIOptions &opts, const elf_info &elf_info, run_info &run_info);
+// Finalizes every hart and exits. Memory is shared, so the signature,
+// memory dumps and checkpoint come from the first hart.
+void finish(const std::vector<ModelImpl *> &models, const CLIOptions &opts, const elf_info &elf_info, run_info &run_info);
 
 // Log management
 
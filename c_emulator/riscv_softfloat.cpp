@@ -1,5 +1,10 @@
 #include "riscv_softfloat.h"
 
+#include "host_fpu.h"
+
+#include <cmath>
+#include <cstring>
+
 // softfloat.h is missing #ifdef __cplusplus etc.
 extern "C" {
 #include "softfloat.h"
@@ -16,8 +21,97 @@ void softfloat_init(uint64_t rm) {
   softfloat_roundingMode = uint8_of_rm(rm);
 }
 
+bool use_host_fpu = false;
+
+#if HOST_FPU_SUPPORTED
+
+template <typename Float, typename Bits> Float float_of_bits(Bits bits) {
+  static_assert(sizeof(Float) == sizeof(Bits));
+  Float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+template <typename Bits, typename Float> Bits bits_of_float(Float f) {
+  static_assert(sizeof(Float) == sizeof(Bits));
+  Bits bits;
+  memcpy(&bits, &f, sizeof(bits));
+  return bits;
+}
+
+// Compute `op` of `n` operands on the host FPU. IEEE 754 fixes the result
+// and flags of these operations except for NaNs and tiny results, where
+// this returns false so that the caller uses softfloat instead (see
+// host_fpu_fallback_exceptions).
+//
+// The operands and result go through volatile variables so that the
+// operation can't be moved outside the code that sets the rounding mode
+// and reads the flags.
+template <typename Float, typename Bits, typename Result, size_t n, typename Op>
+bool host_fpu_op(Result &result, uint64_t rm, const uint64_t (&operands)[n], Op op) {
+  const int mode = host_rounding_mode(rm);
+  if (mode < 0) {
+    return false;
+  }
+
+  volatile Float in[n];
+  for (size_t i = 0; i < n; i++) {
+    in[i] = float_of_bits<Float>(static_cast<Bits>(operands[i]));
+  }
+
+  // The host is left rounding to nearest, which is what almost all
+  // operations use, so only the other modes need to switch.
+  if (mode != FE_TONEAREST) {
+    std::fesetround(mode);
+  }
+  std::feclearexcept(FE_ALL_EXCEPT);
+  volatile Float out = op(in);
+  const int raised = std::fetestexcept(FE_ALL_EXCEPT);
+  if (mode != FE_TONEAREST) {
+    std::fesetround(FE_TONEAREST);
+  }
+
+  const Float value = out;
+  if (std::isnan(value) || (raised & host_fpu_fallback_exceptions) != 0) {
+    return false;
+  }
+
+  const uint64_t flags = fflags_of_host_exceptions(raised);
+  result = {flags, bits_of_float<Bits>(value)};
+  return true;
+}
+
+#else
+
+template <typename Float, typename Bits, typename Result, size_t n, typename Op>
+bool host_fpu_op(Result &, uint64_t, const uint64_t (&)[n], Op) {
+  return false;
+}
+
+#endif
+
+// The operations for host_fpu_op().
+constexpr auto host_add = [](const auto *x) { return x[0] + x[1]; };
+constexpr auto host_sub = [](const auto *x) { return x[0] - x[1]; };
+constexpr auto host_mul = [](const auto *x) { return x[0] * x[1]; };
+constexpr auto host_div = [](const auto *x) { return x[0] / x[1]; };
+constexpr auto host_sqrt = [](const auto *x) { return std::sqrt(x[0]); };
+constexpr auto host_fma = [](const auto *x) { return std::fma(x[0], x[1], x[2]); };
+
 } // namespace
 
+bool softfloat_use_host_fpu(bool enable) {
+  if (enable && !HOST_FPU_SUPPORTED) {
+    return false;
+  }
+  use_host_fpu = enable;
+  return true;
+}
+
+bool softfloat_host_fpu_enabled() {
+  return use_host_fpu;
+}
+
 bv5_bv16 softfloat_f16add(uint64_t rm, uint64_t v1, uint64_t v2) {
   softfloat_init(rm);
 
@@ -63,6 +157,11 @@ bv5_bv16 softfloat_f16div(uint64_t rm, uint64_t v1, uint64_t v2) {
 }
 
 bv5_bv32 softfloat_f32add(uint64_t rm, uint64_t v1, uint64_t v2) {
+  bv5_bv32 result;
+  if (use_host_fpu && host_fpu_op<float, uint32_t>(result, rm, {v1, v2}, host_add)) {
+    return result;
+  }
+
   softfloat_init(rm);
 
   float32_t a, b, res;
@@ -74,6 +173,11 @@ bv5_bv32 softfloat_f32add(uint64_t rm, uint64_t v1, uint64_t v2) {
 }
 
 bv5_bv32 softfloat_f32sub(uint64_t rm, uint64_t v1, uint64_t v2) {
+  bv5_bv32 result;
+  if (use_host_fpu && host_fpu_op<float, uint32_t>(result, rm, {v1, v2}, host_sub)) {
+    return result;
+  }
+
   softfloat_init(rm);
 
   float32_t a, b, res;
@@ -85,6 +189,11 @@ bv5_bv32 softfloat_f32sub(uint64_t rm, uint64_t v1, uint64_t v2) {
 }
 
 bv5_bv32 softfloat_f32mul(uint64_t rm, uint64_t v1, uint64_t v2) {
+  bv5_bv32 result;
+  if (use_host_fpu && host_fpu_op<float, uint32_t>(result, rm, {v1, v2}, host_mul)) {
+    return result;
+  }
+
   softfloat_init(rm);
 
   float32_t a, b, res;
@@ -96,6 +205,11 @@ bv5_bv32 softfloat_f32mul(uint64_t rm, uint64_t v1, uint64_t v2) {
 }
 
 bv5_bv32 softfloat_f32div(uint64_t rm, uint64_t v1, uint64_t v2) {
+  bv5_bv32 result;
+  if (use_host_fpu && host_fpu_op<float, uint32_t>(result, rm, {v1, v2}, host_div)) {
+    return result;
+  }
+
   softfloat_init(rm);
 
   float32_t a, b, res;
@@ -107,6 +221,11 @@ bv5_bv32 softfloat_f32div(uint64_t rm, uint64_t v1, uint64_t v2) {
 }
 
 bv5_bv64 softfloat_f64add(uint64_t rm, uint64_t v1, uint64_t v2) {
+  bv5_bv64 result;
+  if (use_host_fpu && host_fpu_op<double, uint64_t>(result, rm, {v1, v2}, host_add)) {
+    return result;
+  }
+
   softfloat_init(rm);
 
   float64_t a, b, res;
@@ -118,6 +237,11 @@ bv5_bv64 softfloat_f64add(uint64_t rm, uint64_t v1, uint64_t v2) {
 }
 
 bv5_bv64 softfloat_f64sub(uint64_t rm, uint64_t v1, uint64_t v2) {
+  bv5_bv64 result;
+  if (use_host_fpu && host_fpu_op<double, uint64_t>(result, rm, {v1, v2}, host_sub)) {
+    return result;
+  }
+
   softfloat_init(rm);
 
   float64_t a, b, res;
@@ -129,6 +253,11 @@ bv5_bv64 softfloat_f64sub(uint64_t rm, uint64_t v1, uint64_t v2) {
 }
 
 bv5_bv64 softfloat_f64mul(uint64_t rm, uint64_t v1, uint64_t v2) {
+  bv5_bv64 result;
+  if (use_host_fpu && host_fpu_op<double, uint64_t>(result, rm, {v1, v2}, host_mul)) {
+    return result;
+  }
+
   softfloat_init(rm);
 
   float64_t a, b, res;
@@ -140,6 +269,11 @@ bv5_bv64 softfloat_f64mul(uint64_t rm, uint64_t v1, uint64_t v2) {
 }
 
 bv5_bv64 softfloat_f64div(uint64_t rm, uint64_t v1, uint64_t v2) {
+  bv5_bv64 result;
+  if (use_host_fpu && host_fpu_op<double, uint64_t>(result, rm, {v1, v2}, host_div)) {
+    return result;
+  }
+
   softfloat_init(rm);
 
   float64_t a, b, res;
@@ -163,6 +297,15 @@ bv5_bv16 softfloat_f16muladd(uint64_t rm, uint64_t v1, uint64_t v2, uint64_t v3)
 }
 
 bv5_bv32 softfloat_f32muladd(uint64_t rm, uint64_t v1, uint64_t v2, uint64_t v3) {
+  // Only use the host when it has a fused multiply-add instruction; the
+  // library fallback is slower than softfloat.
+#ifdef FP_FAST_FMAF
+  bv5_bv32 result;
+  if (use_host_fpu && host_fpu_op<float, uint32_t>(result, rm, {v1, v2, v3}, host_fma)) {
+    return result;
+  }
+#endif
+
   softfloat_init(rm);
 
   float32_t a, b, c, res;
@@ -175,6 +318,15 @@ bv5_bv32 softfloat_f32muladd(uint64_t rm, uint64_t v1, uint64_t v2, uint64_t v3)
 }
 
 bv5_bv64 softfloat_f64muladd(uint64_t rm, uint64_t v1, uint64_t v2, uint64_t v3) {
+  // Only use the host when it has a fused multiply-add instruction; the
+  // library fallback is slower than softfloat.
+#ifdef FP_FAST_FMA
+  bv5_bv64 result;
+  if (use_host_fpu && host_fpu_op<double, uint64_t>(result, rm, {v1, v2, v3}, host_fma)) {
+    return result;
+  }
+#endif
+
   softfloat_init(rm);
 
   float64_t a, b, c, res;
@@ -197,6 +349,11 @@ bv5_bv16 softfloat_f16sqrt(uint64_t rm, uint64_t v) {
 }
 
 bv5_bv32 softfloat_f32sqrt(uint64_t rm, uint64_t v) {
+  bv5_bv32 result;
+  if (use_host_fpu && host_fpu_op<float, uint32_t>(result, rm, {v}, host_sqrt)) {
+    return result;
+  }
+
   softfloat_init(rm);
 
   float32_t a, res;
@@ -207,6 +364,11 @@ bv5_bv32 softfloat_f32sqrt(uint64_t rm, uint64_t v) {
 }
 
 bv5_bv64 softfloat_f64sqrt(uint64_t rm, uint64_t v) {
+  bv5_bv64 result;
+  if (use_host_fpu && host_fpu_op<double, uint64_t>(result, rm, {v}, host_sqrt)) {
+    return result;
+  }
+
   softfloat_init(rm);
 
   float64_t a, res;
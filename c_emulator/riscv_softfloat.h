@@ -10,6 +10,12 @@ using bv5_bv32 = hart::ztuple_z8z5bv5zCz0z5bv32z9;
 using bv5_bv64 = hart::ztuple_z8z5bv5zCz0z5bv64z9;
 using bv5_bool = hart::ztuple_z8z5bv5zCz0z5boolz9;
 
+// Compute single and double precision arithmetic on the host FPU where it is
+// guaranteed to give the same result and flags as softfloat. Returns false
+// if the host FPU can't be used.
+bool softfloat_use_host_fpu(bool enable);
+bool softfloat_host_fpu_enabled();
+
 bv5_bv16 softfloat_f16add(uint64_t rm, uint64_t v1, uint64_t v2);
 bv5_bv16 softfloat_f16sub(uint64_t rm, uint64_t v1, uint64_t v2);
 bv5_bv16 softfloat_f16mul(uint64_t rm, uint64_t v1, uint64_t v2);
@@ -2,6 +2,8 @@
 #include "gdb/gdb_run_info.h"
 #include "gdb/gdbserver.h"
 #include "riscv_callbacks_log.h"
+#include "riscv_callbacks_profile.h"
+#include "riscv_callbacks_stats.h"
 #include "riscv_callbacks_stop_at_pc.h"
 #include "riscv_model_impl.h"
 #include "riscv_sim.h"
@@ -9,27 +11,35 @@
 
 #include <asio.hpp>
 #include <iostream>
+#include <vector>
 
 namespace {
 
 void run_model(CLIOptions &opts, ModelImpl &model, uint64_t, const elf_info &elf_info, run_info &run_info) {
-  auto loop_detector = std::make_shared<traploop_detector>();
-  if (!opts.disable_trap_loop_detection) {
-    model.register_callback(loop_detector);
+  // Trap loops are detected on each hart separately.
+  std::vector<std::shared_ptr<traploop_detector>> loop_detectors;
+  for (ModelImpl *hart : run_info.harts) {
+    auto loop_detector = std::make_shared<traploop_detector>();
+    if (!opts.disable_trap_loop_detection) {
+      hart->register_callback(loop_detector);
+    }
+    loop_detectors.push_back(std::move(loop_detector));
   }
   std::shared_ptr<stop_at_pc_callbacks> stop_at_pc;
   if (opts.stop_at_pc.has_value()) {
     stop_at_pc = std::make_shared<stop_at_pc_callbacks>(*opts.stop_at_pc);
-    model.register_callback(stop_at_pc);
+    for (ModelImpl *hart : run_info.harts) {
+      hart->register_callback(stop_at_pc);
+    }
   }
 
   do {
-    run_sail(model, opts, loop_detector, stop_at_pc, elf_info, run_info);
-    // `run_sail` only returns in the case of rvfi.
+    run_sail(run_info.harts, opts, loop_detectors, stop_at_pc, elf_info, run_info);
+    // `run_sail` only returns in the case of rvfi, which has a single hart.
     if (run_info.rvfi) {
       /* Reset for next test */
       model.reinit_sail();
-      loop_detector->reset();
+      loop_detectors[0]->reset();
     }
   } while (run_info.rvfi);
 }
@@ -71,9 +81,27 @@ int inner_main(int argc, char **argv) {
     opts.config_print_ptw,
     opts.config_print_tlb,
     opts.config_use_abi_names,
-    run_info.trace_log
+    run_info.trace
   );
-  model.register_callback(log_cbs);
+  for (ModelImpl *hart : run_info.harts) {
+    hart->register_callback(log_cbs);
+  }
+
+  if (!opts.profile_path.empty()) {
+    run_info.profiler = std::make_shared<profile_callbacks>(model, opts.profile_interval);
+    run_info.profile_path = opts.profile_path;
+    for (ModelImpl *hart : run_info.harts) {
+      hart->register_callback(run_info.profiler);
+    }
+  }
+
+  if (!opts.stats_json_path.empty()) {
+    run_info.stats = std::make_shared<stats_callbacks>();
+    run_info.stats_path = opts.stats_json_path;
+    for (ModelImpl *hart : run_info.harts) {
+      hart->register_callback(run_info.stats);
+    }
+  }
 
   if (opts.gdb_server_port != 0) {
     gdb_run_info info = {
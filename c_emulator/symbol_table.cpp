@@ -1,27 +1,87 @@
 #include "symbol_table.h"
-#include <optional>
 
-std::map<uint64_t, std::string> reverse_symbol_table(const std::map<std::string, uint64_t> &symbols) {
-  std::map<uint64_t, std::string> reversed;
-  for (const auto &it : symbols) {
-    // If multiple symbols have the same value the last one alphabetically wins.
-    reversed[it.second] = it.first;
+#include <algorithm>
+
+SymbolTable::SymbolTable(std::vector<Symbol> symbols) {
+  std::stable_sort(symbols.begin(), symbols.end(), [](const Symbol &a, const Symbol &b) {
+    return a.address < b.address;
+  });
+  for (Symbol &symbol : symbols) {
+    if (!m_symbols.empty() && m_symbols.back().address == symbol.address) {
+      if (m_symbols.back().size == 0 && symbol.size != 0) {
+        m_symbols.back() = std::move(symbol);
+      }
+      continue;
+    }
+    m_symbols.push_back(std::move(symbol));
+  }
+
+  m_entries.reserve(m_symbols.size());
+  for (size_t i = 0; i < m_symbols.size(); i++) {
+    const Symbol &symbol = m_symbols[i];
+    uint64_t end = i + 1 < m_symbols.size() ? m_symbols[i + 1].address : UINT64_MAX;
+    if (symbol.size != 0 && symbol.size < end - symbol.address) {
+      end = symbol.address + symbol.size;
+    }
+    m_entries.push_back({symbol.address, end});
   }
-  return reversed;
 }
 
-std::optional<std::pair<uint64_t, const std::string &>> symbolize_address(
-  const std::map<uint64_t, std::string> &symbols,
-  uint64_t address
-) {
-  // Find the first symbol > the address.
-  auto it = symbols.upper_bound(address);
-  if (it == symbols.begin()) {
-    // The very first symbol is greater than the address,
-    // or there are no symbols and begin() = end().
-    return std::nullopt;
-  }
-  // Go back one symbol to the first symbol <= the address.
+bool SymbolTable::entry_after(uint64_t address, const Entry &entry) {
+  return address < entry.address;
+}
+
+size_t SymbolTable::search(uint64_t address, size_t begin, size_t end) const {
+  const Entry *first = m_entries.data() + begin;
+  // Find the first entry > the address.
+  const Entry *it = std::upper_bound(first, m_entries.data() + end, address, entry_after);
+  if (it == first) {
+    return no_symbol;
+  }
+  // Go back one entry to the last entry <= the address.
   --it;
-  return *it;
+  if (address >= it->end) {
+    return no_symbol;
+  }
+  return static_cast<size_t>(it - m_entries.data());
+}
+
+const Symbol *SymbolTable::lookup(uint64_t address) {
+  if (m_last_hit != no_symbol && m_entries[m_last_hit].address <= address && address < m_entries[m_last_hit].end) {
+    return &m_symbols[m_last_hit];
+  }
+
+  const uint64_t page = address >> page_bits;
+  PageCacheEntry &cached = m_page_cache[page % page_cache_size];
+  if (cached.page != page) {
+    // The entries that may contain an address in the page run from the
+    // last entry at or before its start to the last entry in it.
+    const uint64_t first = page << page_bits;
+    const uint64_t last = first | ((uint64_t{1} << page_bits) - 1);
+    auto begin = std::upper_bound(m_entries.begin(), m_entries.end(), first, entry_after);
+    if (begin != m_entries.begin()) {
+      --begin;
+    }
+    auto end = std::upper_bound(begin, m_entries.end(), last, entry_after);
+    cached = {
+      .page = page,
+      .begin = static_cast<size_t>(begin - m_entries.begin()),
+      .end = static_cast<size_t>(end - m_entries.begin()),
+    };
+  }
+
+  const size_t index = search(address, cached.begin, cached.end);
+  if (index == no_symbol) {
+    return nullptr;
+  }
+  m_last_hit = index;
+  return &m_symbols[index];
+}
+
+std::string SymbolTable::describe(uint64_t address) {
+  const Symbol *symbol = lookup(address);
+  if (symbol == nullptr) {
+    return "unknown";
+  }
+  return symbol->name + "+" + std::to_string(address - symbol->address);
 }
@@ -1,17 +1,76 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
-#include <map>
-#include <optional>
 #include <string>
+#include <vector>
 
-// Reverse a symbol table so instead of name->value it's value->name.
-std::map<uint64_t, std::string> reverse_symbol_table(const std::map<std::string, uint64_t> &symbols);
+struct Symbol {
+  std::string name;
+  uint64_t address = 0;
+  // The size from the ELF symbol table, or 0 if it has none (e.g. labels
+  // in assembly). A symbol without a size extends to the next symbol.
+  uint64_t size = 0;
+};
 
-// Find the symbol that is closest to `address` in value (but not greater than
-// it). Return the symbol name and the symbol value (not the offset to
-// `address`).
-std::optional<std::pair<uint64_t, const std::string &>> symbolize_address(
-  const std::map<uint64_t, std::string> &symbols,
-  uint64_t address
-);
+// Maps addresses to the symbols that contain them. The symbols are held in
+// a flat array sorted by address. Lookups first try the last symbol found,
+// then a small cache of the symbols in recently looked up pages, and only
+// search the whole array if both miss, so looking up nearby addresses
+// (e.g. every traced instruction) is cheap.
+//
+// The caches make lookups non-const, so a table can't be shared between
+// threads; copy it instead.
+class SymbolTable {
+public:
+  SymbolTable() = default;
+  // If several symbols have the same address, the first one with a size
+  // is used, or else the first one.
+  explicit SymbolTable(std::vector<Symbol> symbols);
+
+  bool empty() const {
+    return m_symbols.empty();
+  }
+
+  // The symbol that contains `address`, or nullptr if it is before the
+  // first symbol, or past the size of the last symbol at or before it.
+  // The pointer is valid as long as the table.
+  const Symbol *lookup(uint64_t address);
+
+  // `address` as `<symbol>+<offset>`, or "unknown" if it has no symbol.
+  std::string describe(uint64_t address);
+
+private:
+  // Each symbol covers [address, end), up to the next symbol or its size,
+  // whichever is sooner.
+  struct Entry {
+    uint64_t address;
+    uint64_t end;
+  };
+
+  // For std::upper_bound().
+  static bool entry_after(uint64_t address, const Entry &entry);
+
+  // Returns the index of the symbol that contains `address` or
+  // `no_symbol`, searching only the entries [begin, end).
+  size_t search(uint64_t address, size_t begin, size_t end) const;
+
+  static constexpr size_t no_symbol = SIZE_MAX;
+  static constexpr unsigned page_bits = 12;
+  static constexpr size_t page_cache_size = 64;
+
+  // For each cached page, the range of entries that may contain an
+  // address in it.
+  struct PageCacheEntry {
+    uint64_t page = UINT64_MAX;
+    size_t begin = 0;
+    size_t end = 0;
+  };
+
+  // The entries are kept apart from the names so that searches touch as
+  // little memory as possible.
+  std::vector<Entry> m_entries;
+  std::vector<Symbol> m_symbols;
+  size_t m_last_hit = no_symbol;
+  std::array<PageCacheEntry, page_cache_size> m_page_cache = {};
+};
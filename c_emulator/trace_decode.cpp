@@ -0,0 +1,24 @@
+// Prints a trace written with `--trace-format binary` in the text format.
+
+#include "binary_trace.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    fprintf(stderr, "Usage: %s <trace file>\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  try {
+    decode_binary_trace(argv[1], stdout);
+  } catch (const std::exception &exc) {
+    fflush(stdout);
+    std::cerr << "Error: " << exc.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,207 @@
+#include "trace_format.h"
+
+#include <algorithm>
+#include <inttypes.h>
+#include <string>
+
+namespace {
+
+// Print a little-endian value as "0x" followed by upper case hex digits,
+// zero padded to `digits`. This matches gmp's "0x%0*ZX".
+void print_hex(FILE *out, const uint8_t *value, size_t value_bytes, int digits) {
+  size_t significant = value_bytes * 2;
+  while (significant > 1) {
+    const size_t nibble = significant - 1;
+    if (((value[nibble / 2] >> (4 * (nibble % 2))) & 0xF) != 0) {
+      break;
+    }
+    --significant;
+  }
+  const size_t width = std::max(significant, static_cast<size_t>(std::max(digits, 0)));
+
+  static const char hex_digits[] = "0123456789ABCDEF";
+  std::string text(width, '0');
+  for (size_t nibble = 0; nibble < std::min(width, value_bytes * 2); ++nibble) {
+    text[width - 1 - nibble] = hex_digits[(value[nibble / 2] >> (4 * (nibble % 2))) & 0xF];
+  }
+  fprintf(out, "0x%s\n", text.c_str());
+}
+
+} // namespace
+
+void print_instr(FILE *out, const TraceInstr &instr) {
+  int length = fprintf(out, "[%" PRIu64 "] ", instr.step);
+  if (instr.hart >= 0) {
+    length += fprintf(out, "[hart %" PRIi64 "] ", instr.hart);
+  }
+  length += fprintf(
+    out,
+    "[%s]: 0x%0*" PRIX64 " (0x%0*" PRIX64 ") %s",
+    instr.privilege,
+    instr.pc_digits,
+    instr.pc,
+    instr.opcode_digits,
+    instr.opcode,
+    instr.disassembly
+  );
+  if (instr.symbol != nullptr) {
+    // Line the symbols up in a column.
+    constexpr int symbol_column = 80;
+    fprintf(out, "%*s    %s+%" PRIu64, std::max(symbol_column - length, 0), "", instr.symbol, instr.symbol_offset);
+  }
+  fputc('\n', out);
+}
+
+void print_mem_access(
+  FILE *out,
+  const char *type,
+  bool is_write,
+  uint64_t paddr,
+  int paddr_digits,
+  const uint8_t *value,
+  size_t value_bytes,
+  int digits
+) {
+  fprintf(out, "mem[%s,0x%0*" PRIX64 "] %s ", type, paddr_digits, paddr, is_write ? "<-" : "->");
+  print_hex(out, value, value_bytes, digits);
+}
+
+void print_xreg_write(FILE *out, const char *abi_name, uint64_t reg, uint64_t value, int digits) {
+  if (abi_name != nullptr) {
+    fprintf(out, "%s <- 0x%0*" PRIX64 "\n", abi_name, digits, value);
+  } else {
+    fprintf(out, "x%" PRIu64 " <- 0x%0*" PRIX64 "\n", reg, digits, value);
+  }
+}
+
+void print_freg_write(FILE *out, unsigned reg, uint64_t value, int digits) {
+  // TODO: will only print bits; should we print in floating point format?
+  // TODO: Might need to change from PRIX64 to PRIX128 once the "Q"
+  // extension is supported
+  fprintf(out, "f%d <- 0x%0*" PRIX64 "\n", reg, digits, value);
+}
+
+void print_csr_access(FILE *out, const char *csr_name, unsigned reg, bool is_write, uint64_t value, int digits) {
+  fprintf(out, "CSR %s (0x%03X) %s 0x%0*" PRIX64 "\n", csr_name, reg, is_write ? "<-" : "->", digits, value);
+}
+
+void print_vreg_write(FILE *out, unsigned reg, const uint8_t *value, size_t value_bytes, int digits) {
+  fprintf(out, "v%d <- ", reg);
+  print_hex(out, value, value_bytes, digits);
+}
+
+void print_ptw_start(FILE *out, uint64_t vpn, const char *access_type, const char *privilege) {
+  fprintf(out, "PTW: Start, vpn=0x%" PRIx64 ", access_type=%s, privilege=%s\n", vpn, access_type, privilege);
+}
+
+void print_ptw_step(FILE *out, int64_t level, uint64_t pte, uint64_t pte_addr) {
+  fprintf(out, "PTW: Step, level=%" PRId64 ", pte=0x%" PRIX64 ", pte_addr=0x%" PRIX64 "\n", level, pte, pte_addr);
+}
+
+void print_ptw_success(FILE *out, uint64_t final_ppn, int64_t level) {
+  fprintf(out, "PTW: Success, final_ppn=0x%" PRIx64 ", level=%" PRId64 "\n", final_ppn, level);
+}
+
+void print_ptw_fail(FILE *out, const char *error, int64_t level, uint64_t pte_addr) {
+  fprintf(out, "PTW: failed, error=%s, level=%" PRId64 ", pte_addr=0x%" PRIX64 "\n", error, level, pte_addr);
+}
+
+void print_tlb(FILE *out, const std::vector<TraceTlbEntry> &entries, bool is_flush) {
+  fprintf(
+    out,
+    "TLB %s [ entries=%zu ]\n"
+    "╔═════╦════╦══════════╦══════════════════════╦══════════════════════╦══════════════════════╦══════════════════════"
+    "╦══════════════════════"
+    "╗\n"
+    "║ IDX ║ GL ║   ASID   ║         VPN          ║         PTE          ║     LEVEL_MASK       ║         PPN          "
+    "║       PTE_ADDR       "
+    "║\n"
+    "╠═════╬════╬══════════╬══════════════════════╬══════════════════════╬══════════════════════╬══════════════════════"
+    "╬══════════════════════"
+    "╣\n",
+    is_flush ? "flush" : "add",
+    entries.size()
+  );
+  for (const auto &e : entries) {
+    fprintf(
+      out,
+      "║ %3" PRIu64 " ║  %c ║ 0x%06" PRIX64 " ║ 0x%018" PRIX64 " ║ 0x%018" PRIX64 " ║ 0x%018" PRIX64 " ║ 0x%018" PRIX64
+      " ║ 0x%018" PRIX64 " ║\n",
+      e.index,
+      e.global ? 'Y' : 'N',
+      e.asid,
+      e.vpn,
+      e.pte,
+      e.level_mask,
+      e.ppn,
+      e.pte_addr
+    );
+  }
+  fprintf(
+    out,
+    "╚═════╩════╩══════════╩══════════════════════╩══════════════════════╩══════════════════════╩══════════════════════"
+    "╩══════════════════════"
+    "╝\n"
+  );
+}
+
+void TextTraceSink::text(std::string_view s) {
+  fwrite(s.data(), 1, s.size(), m_out);
+}
+
+void TextTraceSink::line(std::string_view s) {
+  fwrite(s.data(), 1, s.size(), m_out);
+  fputc('\n', m_out);
+}
+
+void TextTraceSink::instr(const TraceInstr &instr) {
+  print_instr(m_out, instr);
+}
+
+void TextTraceSink::mem_access(
+  const char *type,
+  bool is_write,
+  uint64_t paddr,
+  int paddr_digits,
+  const uint8_t *value,
+  size_t value_bytes,
+  int digits
+) {
+  print_mem_access(m_out, type, is_write, paddr, paddr_digits, value, value_bytes, digits);
+}
+
+void TextTraceSink::xreg_write(const char *abi_name, uint64_t reg, uint64_t value, int digits) {
+  print_xreg_write(m_out, abi_name, reg, value, digits);
+}
+
+void TextTraceSink::freg_write(unsigned reg, uint64_t value, int digits) {
+  print_freg_write(m_out, reg, value, digits);
+}
+
+void TextTraceSink::csr_access(const char *csr_name, unsigned reg, bool is_write, uint64_t value, int digits) {
+  print_csr_access(m_out, csr_name, reg, is_write, value, digits);
+}
+
+void TextTraceSink::vreg_write(unsigned reg, const uint8_t *value, size_t value_bytes, int digits) {
+  print_vreg_write(m_out, reg, value, value_bytes, digits);
+}
+
+void TextTraceSink::ptw_start(uint64_t vpn, const char *access_type, const char *privilege) {
+  print_ptw_start(m_out, vpn, access_type, privilege);
+}
+
+void TextTraceSink::ptw_step(int64_t level, uint64_t pte, uint64_t pte_addr) {
+  print_ptw_step(m_out, level, pte, pte_addr);
+}
+
+void TextTraceSink::ptw_success(uint64_t final_ppn, int64_t level) {
+  print_ptw_success(m_out, final_ppn, level);
+}
+
+void TextTraceSink::ptw_fail(const char *error, int64_t level, uint64_t pte_addr) {
+  print_ptw_fail(m_out, error, level, pte_addr);
+}
+
+void TextTraceSink::tlb(const std::vector<TraceTlbEntry> &entries, bool is_flush) {
+  print_tlb(m_out, entries, is_flush);
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string_view>
+#include <vector>
+
+// Formatters for the text trace. These work on plain values rather than
+// Sail types so that the emulator and the offline binary trace decoder
+// produce exactly the same output.
+//
+// Values wider than 64 bits are passed as little-endian bytes and printed
+// with at least `digits` hex digits.
+
+// A retired instruction, printed as
+// `[<step>] [<privilege>]: <pc> (<opcode>) <disassembly>`, followed by the
+// symbol that contains the PC and the offset into it if `symbol` is not
+// null. If `hart` is not negative, `[hart <hart>]` follows the step.
+struct TraceInstr {
+  uint64_t step = 0;
+  int64_t hart = -1;
+  const char *privilege = nullptr;
+  uint64_t pc = 0;
+  int pc_digits = 0;
+  uint64_t opcode = 0;
+  int opcode_digits = 0;
+  const char *disassembly = nullptr;
+  const char *symbol = nullptr;
+  uint64_t symbol_offset = 0;
+};
+
+void print_instr(FILE *out, const TraceInstr &instr);
+
+void print_mem_access(
+  FILE *out,
+  const char *type,
+  bool is_write,
+  uint64_t paddr,
+  int paddr_digits,
+  const uint8_t *value,
+  size_t value_bytes,
+  int digits
+);
+
+// `abi_name` is used instead of "x<reg>" if it is not null.
+void print_xreg_write(FILE *out, const char *abi_name, uint64_t reg, uint64_t value, int digits);
+
+void print_freg_write(FILE *out, unsigned reg, uint64_t value, int digits);
+
+void print_csr_access(FILE *out, const char *csr_name, unsigned reg, bool is_write, uint64_t value, int digits);
+
+void print_vreg_write(FILE *out, unsigned reg, const uint8_t *value, size_t value_bytes, int digits);
+
+void print_ptw_start(FILE *out, uint64_t vpn, const char *access_type, const char *privilege);
+
+void print_ptw_step(FILE *out, int64_t level, uint64_t pte, uint64_t pte_addr);
+
+void print_ptw_success(FILE *out, uint64_t final_ppn, int64_t level);
+
+void print_ptw_fail(FILE *out, const char *error, int64_t level, uint64_t pte_addr);
+
+struct TraceTlbEntry {
+  uint64_t index = 0;
+  bool global = false;
+  uint64_t asid = 0;
+  uint64_t vpn = 0;
+  uint64_t pte = 0;
+  uint64_t level_mask = 0;
+  uint64_t ppn = 0;
+  uint64_t pte_addr = 0;
+};
+
+// Print the TLB entries that were added or flushed, with their indices.
+void print_tlb(FILE *out, const std::vector<TraceTlbEntry> &entries, bool is_flush);
+
+// Where trace events go: printed as text with the functions above, or
+// recorded in a binary trace (BinaryTraceWriter). Code that produces
+// trace events writes them here without having to know which.
+class TraceSink {
+public:
+  virtual ~TraceSink() = default;
+
+  // Text that is already formatted.
+  virtual void text(std::string_view s) = 0;
+  // As text(), followed by a newline.
+  virtual void line(std::string_view s) = 0;
+
+  virtual void instr(const TraceInstr &instr) = 0;
+  virtual void mem_access(
+    const char *type,
+    bool is_write,
+    uint64_t paddr,
+    int paddr_digits,
+    const uint8_t *value,
+    size_t value_bytes,
+    int digits
+  ) = 0;
+  virtual void xreg_write(const char *abi_name, uint64_t reg, uint64_t value, int digits) = 0;
+  virtual void freg_write(unsigned reg, uint64_t value, int digits) = 0;
+  virtual void csr_access(const char *csr_name, unsigned reg, bool is_write, uint64_t value, int digits) = 0;
+  virtual void vreg_write(unsigned reg, const uint8_t *value, size_t value_bytes, int digits) = 0;
+  virtual void ptw_start(uint64_t vpn, const char *access_type, const char *privilege) = 0;
+  virtual void ptw_step(int64_t level, uint64_t pte, uint64_t pte_addr) = 0;
+  virtual void ptw_success(uint64_t final_ppn, int64_t level) = 0;
+  virtual void ptw_fail(const char *error, int64_t level, uint64_t pte_addr) = 0;
+  virtual void tlb(const std::vector<TraceTlbEntry> &entries, bool is_flush) = 0;
+};
+
+// Prints the text trace to a file, which it does not own.
+class TextTraceSink : public TraceSink {
+public:
+  explicit TextTraceSink(FILE *out) : m_out(out) {
+  }
+
+  void text(std::string_view s) override;
+  void line(std::string_view s) override;
+  void instr(const TraceInstr &instr) override;
+  void mem_access(
+    const char *type,
+    bool is_write,
+    uint64_t paddr,
+    int paddr_digits,
+    const uint8_t *value,
+    size_t value_bytes,
+    int digits
+  ) override;
+  void xreg_write(const char *abi_name, uint64_t reg, uint64_t value, int digits) override;
+  void freg_write(unsigned reg, uint64_t value, int digits) override;
+  void csr_access(const char *csr_name, unsigned reg, bool is_write, uint64_t value, int digits) override;
+  void vreg_write(unsigned reg, const uint8_t *value, size_t value_bytes, int digits) override;
+  void ptw_start(uint64_t vpn, const char *access_type, const char *privilege) override;
+  void ptw_step(int64_t level, uint64_t pte, uint64_t pte_addr) override;
+  void ptw_success(uint64_t final_ppn, int64_t level) override;
+  void ptw_fail(const char *error, int64_t level, uint64_t pte_addr) override;
+  void tlb(const std::vector<TraceTlbEntry> &entries, bool is_flush) override;
+
+private:
+  FILE *m_out;
+};
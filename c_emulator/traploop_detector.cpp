@@ -20,6 +20,9 @@ void traploop_detector::trap_callback(ModelImpl &model, bool, fbits) {
   }
   nested_trap_count++;
   instrets_since_last_trap = 0;
+  if (loop_detected()) {
+    model.request_stop();
+  }
 }
 
 void traploop_detector::xret_callback(ModelImpl &, bool) {
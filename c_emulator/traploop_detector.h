@@ -14,6 +14,9 @@ public:
   uint64_t sepc() const;
 
   // callbacks_if
+  callback_event_mask subscribed_events() const override {
+    return overridden_callback_events<traploop_detector>();
+  }
   void trap_callback(ModelImpl &model, bool is_interrupt, fbits cause) override;
   void xret_callback(ModelImpl &model, bool is_mret) override;
   void instret_callback(ModelImpl &model) override;
@@ -0,0 +1,226 @@
+#include "vector_kernels.h"
+
+#include "host_fpu.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// The kernels are written once, in vector_kernels_impl.h, with GCC vector
+// extensions (which Clang supports too), and compiled for each instruction
+// set below.
+
+namespace {
+
+// The registers hold little-endian elements, so they can only be used as
+// host integers and floats on a little-endian host.
+constexpr bool host_is_little_endian = __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+
+template <typename T, size_t bytes> struct Simd {
+  typedef T vec __attribute__((vector_size(bytes)));
+};
+
+[[gnu::always_inline]] inline bool element_enabled(const uint8_t *mask, size_t i) {
+  return mask == nullptr || ((mask[i / 8] >> (i % 8)) & 1) != 0;
+}
+
+[[maybe_unused]] bool any_element_enabled(const VectorKernelArgs &args) {
+  for (size_t i = args.start; i < args.end; i++) {
+    if (element_enabled(args.mask, i)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// The instruction sets. Each namespace defines int_kernel() and
+// fp_kernel() (see vector_kernels_impl.h).
+
+#if defined(__x86_64__)
+
+// SSE2 is part of x86-64, so this is always available.
+namespace sse2 {
+
+constexpr size_t vector_bytes = 16;
+constexpr bool has_fma = false;
+
+#include "vector_kernels_impl.h"
+
+} // namespace sse2
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+
+namespace avx2 {
+
+constexpr size_t vector_bytes = 32;
+constexpr bool has_fma = true;
+
+[[gnu::always_inline]] inline float fma(float a, float b, float c) {
+  return __builtin_fmaf(a, b, c);
+}
+
+[[gnu::always_inline]] inline double fma(double a, double b, double c) {
+  return __builtin_fma(a, b, c);
+}
+
+[[gnu::always_inline]] inline Simd<float, 32>::vec
+fma(Simd<float, 32>::vec a, Simd<float, 32>::vec b, Simd<float, 32>::vec c) {
+  return _mm256_fmadd_ps(a, b, c);
+}
+
+[[gnu::always_inline]] inline Simd<double, 32>::vec
+fma(Simd<double, 32>::vec a, Simd<double, 32>::vec b, Simd<double, 32>::vec c) {
+  return _mm256_fmadd_pd(a, b, c);
+}
+
+#include "vector_kernels_impl.h"
+
+} // namespace avx2
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+
+// Advanced SIMD is part of AArch64, so this is always available.
+namespace neon {
+
+constexpr size_t vector_bytes = 16;
+constexpr bool has_fma = true;
+
+[[gnu::always_inline]] inline float fma(float a, float b, float c) {
+  return __builtin_fmaf(a, b, c);
+}
+
+[[gnu::always_inline]] inline double fma(double a, double b, double c) {
+  return __builtin_fma(a, b, c);
+}
+
+[[gnu::always_inline]] inline Simd<float, 16>::vec
+fma(Simd<float, 16>::vec a, Simd<float, 16>::vec b, Simd<float, 16>::vec c) {
+  return vfmaq_f32(c, a, b);
+}
+
+[[gnu::always_inline]] inline Simd<double, 16>::vec
+fma(Simd<double, 16>::vec a, Simd<double, 16>::vec b, Simd<double, 16>::vec c) {
+  return vfmaq_f64(c, a, b);
+}
+
+#include "vector_kernels_impl.h"
+
+} // namespace neon
+
+#else
+
+namespace scalar {
+
+constexpr size_t vector_bytes = 0;
+constexpr bool has_fma = false;
+
+#include "vector_kernels_impl.h"
+
+} // namespace scalar
+
+#endif
+
+struct Kernels {
+  const char *isa;
+  bool has_fma;
+  bool (*int_kernel)(VectorKernelOp op, size_t sew_bytes, const VectorKernelArgs &args);
+  bool (*fp_kernel)(VectorKernelOp op, size_t sew_bytes, const VectorKernelArgs &args, uint8_t *out);
+};
+
+Kernels select_kernels() {
+#if defined(__x86_64__)
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return {"avx2", avx2::has_fma, avx2::int_kernel, avx2::fp_kernel};
+  }
+  return {"sse2", sse2::has_fma, sse2::int_kernel, sse2::fp_kernel};
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+  return {"neon", neon::has_fma, neon::int_kernel, neon::fp_kernel};
+#else
+  return {"scalar", scalar::has_fma, scalar::int_kernel, scalar::fp_kernel};
+#endif
+}
+
+const Kernels &kernels() {
+  static const Kernels selected = select_kernels();
+  return selected;
+}
+
+} // namespace
+
+bool vector_int_kernel(VectorKernelOp op, size_t sew_bytes, const VectorKernelArgs &args) {
+  if (!host_is_little_endian) {
+    return false;
+  }
+  return kernels().int_kernel(op, sew_bytes, args);
+}
+
+std::optional<uint64_t>
+vector_fp_kernel(VectorKernelOp op, size_t sew_bytes, uint64_t rm, const VectorKernelArgs &args, uint8_t *scratch) {
+#if HOST_FPU_SUPPORTED
+  const Kernels &k = kernels();
+  const int mode = host_rounding_mode(rm);
+  if (!host_is_little_endian || mode < 0 || (sew_bytes != 4 && sew_bytes != 8) ||
+      (op == VectorKernelOp::macc && !k.has_fma)) {
+    return std::nullopt;
+  }
+  // The model accrues the flags of each active element, which can mark the
+  // F state dirty even if there are none, so leave it instructions without
+  // any.
+  if (!any_element_enabled(args)) {
+    return std::nullopt;
+  }
+
+  // Compute into `scratch`, so that vd is unchanged if softfloat has to
+  // be used instead.
+  if (mode != FE_TONEAREST) {
+    std::fesetround(mode);
+  }
+  std::feclearexcept(FE_ALL_EXCEPT);
+  const bool ok = k.fp_kernel(op, sew_bytes, args, scratch);
+  const int raised = std::fetestexcept(FE_ALL_EXCEPT);
+  if (mode != FE_TONEAREST) {
+    std::fesetround(FE_TONEAREST);
+  }
+  if (!ok || (raised & host_fpu_fallback_exceptions) != 0) {
+    return std::nullopt;
+  }
+
+  if (args.mask == nullptr) {
+    memcpy(args.vd + args.start * sew_bytes, scratch + args.start * sew_bytes, (args.end - args.start) * sew_bytes);
+  } else {
+    for (size_t i = args.start; i < args.end; i++) {
+      if (element_enabled(args.mask, i)) {
+        memcpy(args.vd + i * sew_bytes, scratch + i * sew_bytes, sew_bytes);
+      }
+    }
+  }
+  return fflags_of_host_exceptions(raised);
+#else
+  (void)op;
+  (void)sew_bytes;
+  (void)rm;
+  (void)args;
+  (void)scratch;
+  return std::nullopt;
+#endif
+}
+
+const char *vector_kernel_isa() {
+  return kernels().isa;
+}
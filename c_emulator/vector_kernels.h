@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+// Element-wise vector arithmetic on the vector register file (see
+// VRegFile), using the widest SIMD instructions of the host CPU. The
+// implementation is chosen when first used, from the CPU's features.
+
+enum class VectorKernelOp {
+  // vd = vs2 + vs1
+  add,
+  // vd = vs2 - vs1
+  sub,
+  // vd = vs2 * vs1
+  mul,
+  // vd = vs1 * vs2 + vd
+  macc,
+};
+
+struct VectorKernelArgs {
+  // The first byte of each register group. vd is also an operand of macc.
+  uint8_t *vd = nullptr;
+  const uint8_t *vs2 = nullptr;
+  // If null, `scalar` is used for every element instead.
+  const uint8_t *vs1 = nullptr;
+  uint64_t scalar = 0;
+  // v0, or null if the instruction is unmasked.
+  const uint8_t *mask = nullptr;
+  // The elements [start, end) are computed, if enabled by the mask.
+  size_t start = 0;
+  size_t end = 0;
+};
+
+// Compute an integer `op` of `sew_bytes`-byte elements. Returns false if
+// there is no kernel for it.
+bool vector_int_kernel(VectorKernelOp op, size_t sew_bytes, const VectorKernelArgs &args);
+
+// Compute a floating point `op` of 4 or 8-byte elements in RISC-V rounding
+// mode `rm`, and return the accrued fflags. Returns std::nullopt, leaving
+// vd unchanged, if there is no kernel for it or the result might differ
+// from softfloat's (see host_fpu.h). `scratch` must have room for the
+// whole of vd.
+std::optional<uint64_t>
+vector_fp_kernel(VectorKernelOp op, size_t sew_bytes, uint64_t rm, const VectorKernelArgs &args, uint8_t *scratch);
+
+// The instruction set of the kernels in use, e.g. "avx2".
+const char *vector_kernel_isa();
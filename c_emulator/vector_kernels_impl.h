@@ -0,0 +1,180 @@
+// The vector kernels, included by vector_kernels.cpp once for each
+// instruction set, inside a namespace that defines:
+//
+// - `vector_bytes`: the vector width, or 0 for plain scalar code.
+// - `has_fma`: whether `fma()` is a fused multiply-add instruction.
+// - `fma(a, b, c)`: a * b + c for elements and vectors, if `has_fma`.
+//
+// and with that instruction set's target options, so that everything
+// here is compiled for it. This defines the namespace's int_kernel() and
+// fp_kernel().
+
+// These are here rather than shared so that vectors are only passed
+// between functions compiled for the same instruction set.
+template <typename T> [[gnu::always_inline]] inline T load(const uint8_t *p) {
+  T value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+template <typename T> [[gnu::always_inline]] inline void store(uint8_t *p, T value) {
+  memcpy(p, &value, sizeof(value));
+}
+
+// Integer operations, on elements or vectors of them. The casts undo C++'s
+// promotion of narrow integers.
+template <VectorKernelOp op, typename T> [[gnu::always_inline]] inline T int_op(T vs2, T vs1, T vd) {
+  switch (op) {
+  case VectorKernelOp::add:
+    return static_cast<T>(vs2 + vs1);
+  case VectorKernelOp::sub:
+    return static_cast<T>(vs2 - vs1);
+  case VectorKernelOp::mul:
+    return static_cast<T>(vs2 * vs1);
+  case VectorKernelOp::macc:
+    return static_cast<T>(vs1 * vs2 + vd);
+  }
+  return vd;
+}
+
+// Compute integer `op` of elements of type T. Masked instructions are
+// done an element at a time.
+template <VectorKernelOp op, typename T> [[gnu::always_inline]] inline void int_elements(const VectorKernelArgs &args) {
+  size_t i = args.start;
+  if constexpr (vector_bytes != 0) {
+    using V = typename Simd<T, vector_bytes>::vec;
+    constexpr size_t lanes = vector_bytes / sizeof(T);
+    if (args.mask == nullptr) {
+      const V scalar = V{} + static_cast<T>(args.scalar);
+      for (; i + lanes <= args.end; i += lanes) {
+        const size_t offset = i * sizeof(T);
+        const V vs1 = args.vs1 != nullptr ? load<V>(args.vs1 + offset) : scalar;
+        store(args.vd + offset, int_op<op>(load<V>(args.vs2 + offset), vs1, load<V>(args.vd + offset)));
+      }
+    }
+  }
+  for (; i < args.end; i++) {
+    if (element_enabled(args.mask, i)) {
+      const size_t offset = i * sizeof(T);
+      const T vs1 = args.vs1 != nullptr ? load<T>(args.vs1 + offset) : static_cast<T>(args.scalar);
+      store(args.vd + offset, int_op<op>(load<T>(args.vs2 + offset), vs1, load<T>(args.vd + offset)));
+    }
+  }
+}
+
+template <typename T> [[gnu::always_inline]] inline void int_kernel(VectorKernelOp op, const VectorKernelArgs &args) {
+  switch (op) {
+  case VectorKernelOp::add:
+    int_elements<VectorKernelOp::add, T>(args);
+    break;
+  case VectorKernelOp::sub:
+    int_elements<VectorKernelOp::sub, T>(args);
+    break;
+  case VectorKernelOp::mul:
+    int_elements<VectorKernelOp::mul, T>(args);
+    break;
+  case VectorKernelOp::macc:
+    int_elements<VectorKernelOp::macc, T>(args);
+    break;
+  }
+}
+
+bool int_kernel(VectorKernelOp op, size_t sew_bytes, const VectorKernelArgs &args) {
+  switch (sew_bytes) {
+  case 1:
+    int_kernel<uint8_t>(op, args);
+    return true;
+  case 2:
+    int_kernel<uint16_t>(op, args);
+    return true;
+  case 4:
+    int_kernel<uint32_t>(op, args);
+    return true;
+  case 8:
+    int_kernel<uint64_t>(op, args);
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Floating point operations, on elements or vectors of them. The caller
+// sets the rounding mode and collects the exceptions.
+template <VectorKernelOp op, typename T> [[gnu::always_inline]] inline T fp_op(T vs2, T vs1, T vd) {
+  switch (op) {
+  case VectorKernelOp::add:
+    return vs2 + vs1;
+  case VectorKernelOp::sub:
+    return vs2 - vs1;
+  case VectorKernelOp::mul:
+    return vs2 * vs1;
+  case VectorKernelOp::macc:
+    if constexpr (has_fma) {
+      return fma(vs1, vs2, vd);
+    }
+  }
+  return vd;
+}
+
+// Compute floating point `op` of elements of type F into `out`, and
+// return whether any result is a NaN.
+template <VectorKernelOp op, typename F>
+[[gnu::always_inline]] inline bool fp_elements(const VectorKernelArgs &args, uint8_t *out) {
+  size_t i = args.start;
+  bool any_nan = false;
+  if constexpr (vector_bytes != 0) {
+    using V = typename Simd<F, vector_bytes>::vec;
+    constexpr size_t lanes = vector_bytes / sizeof(F);
+    if (args.mask == nullptr) {
+      F scalar_value;
+      memcpy(&scalar_value, &args.scalar, sizeof(scalar_value));
+      const V scalar = V{} + scalar_value;
+      decltype(scalar != scalar) nans{};
+      for (; i + lanes <= args.end; i += lanes) {
+        const size_t offset = i * sizeof(F);
+        const V vs1 = args.vs1 != nullptr ? load<V>(args.vs1 + offset) : scalar;
+        const V result = fp_op<op>(load<V>(args.vs2 + offset), vs1, load<V>(args.vd + offset));
+        nans |= result != result;
+        store(out + offset, result);
+      }
+      for (size_t lane = 0; lane < lanes; lane++) {
+        any_nan |= nans[lane] != 0;
+      }
+    }
+  }
+  for (; i < args.end; i++) {
+    if (element_enabled(args.mask, i)) {
+      const size_t offset = i * sizeof(F);
+      F vs1;
+      if (args.vs1 != nullptr) {
+        vs1 = load<F>(args.vs1 + offset);
+      } else {
+        memcpy(&vs1, &args.scalar, sizeof(vs1));
+      }
+      const F result = fp_op<op>(load<F>(args.vs2 + offset), vs1, load<F>(args.vd + offset));
+      any_nan |= result != result;
+      store(out + offset, result);
+    }
+  }
+  return any_nan;
+}
+
+template <typename F>
+[[gnu::always_inline]] inline bool fp_kernel(VectorKernelOp op, const VectorKernelArgs &args, uint8_t *out) {
+  switch (op) {
+  case VectorKernelOp::add:
+    return fp_elements<VectorKernelOp::add, F>(args, out);
+  case VectorKernelOp::sub:
+    return fp_elements<VectorKernelOp::sub, F>(args, out);
+  case VectorKernelOp::mul:
+    return fp_elements<VectorKernelOp::mul, F>(args, out);
+  case VectorKernelOp::macc:
+    return fp_elements<VectorKernelOp::macc, F>(args, out);
+  }
+  return true;
+}
+
+// Returns false if any result is a NaN.
+bool fp_kernel(VectorKernelOp op, size_t sew_bytes, const VectorKernelArgs &args, uint8_t *out) {
+  return !(sew_bytes == 4 ? fp_kernel<float>(op, args, out) : fp_kernel<double>(op, args, out));
+}
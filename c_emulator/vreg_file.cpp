@@ -0,0 +1,8 @@
+#include "vreg_file.h"
+
+void VRegFile::reset(size_t vlen_bytes) {
+  const size_t lines = (num_regs * vlen_bytes + line_size - 1) / line_size;
+  // Value-initialised, so the registers start as zero.
+  m_lines = std::make_unique<Line[]>(lines);
+  m_vlen_bytes = vlen_bytes;
+}
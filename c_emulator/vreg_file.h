@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// The vector registers, held as plain little-endian bytes rather than as
+// arbitrary-precision integers. All 32 registers are in one allocation that
+// starts on a cache line, so an element access is a load or store at a
+// fixed offset and never allocates.
+class VRegFile {
+public:
+  static constexpr unsigned num_regs = 32;
+
+  // Allocate zeroed registers of `vlen_bytes` bytes each.
+  void reset(size_t vlen_bytes);
+
+  size_t vlen_bytes() const {
+    return m_vlen_bytes;
+  }
+
+  uint8_t *reg(unsigned r) {
+    return m_lines[0].bytes + r * m_vlen_bytes;
+  }
+
+  const uint8_t *reg(unsigned r) const {
+    return m_lines[0].bytes + r * m_vlen_bytes;
+  }
+
+  // Whether `size` bytes starting at register `r` are within the registers.
+  bool contains(unsigned r, size_t size) const {
+    return r < num_regs && size <= (num_regs - r) * m_vlen_bytes;
+  }
+
+  // Read the `bytes`-byte element at `offset` bytes into register `r`.
+  uint64_t read_element(unsigned r, size_t offset, size_t bytes) const {
+    const uint8_t *p = reg(r) + offset;
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; i++) {
+      value |= uint64_t{p[i]} << (8 * i);
+    }
+    return value;
+  }
+
+  void write_element(unsigned r, size_t offset, size_t bytes, uint64_t value) {
+    uint8_t *p = reg(r) + offset;
+    for (size_t i = 0; i < bytes; i++) {
+      p[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+  }
+
+private:
+  static constexpr size_t line_size = 64;
+
+  struct alignas(line_size) Line {
+    uint8_t bytes[line_size];
+  };
+
+  std::unique_ptr<Line[]> m_lines;
+  size_t m_vlen_bytes = 0;
+};
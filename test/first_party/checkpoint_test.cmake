@@ -0,0 +1,51 @@
+# Checks that a run that is checkpointed part way through and restored
+# executes exactly the same instructions as an uninterrupted run.
+#
+# Run with `cmake -P` and these variables:
+#   SIM        - the sail_riscv_sim executable.
+#   CONFIG     - the configuration file.
+#   ELF        - the program to run, which must retire more than INST_LIMIT
+#                instructions.
+#   INST_LIMIT - the number of instructions after which to save the
+#                checkpoint.
+#   WORK_DIR   - a directory for the checkpoint and the traces.
+
+include("${CMAKE_CURRENT_LIST_DIR}/script_test.cmake")
+script_test_setup(INST_LIMIT)
+set(checkpoint "${WORK_DIR}/checkpoint")
+
+# Run the simulator with an instruction trace written to `trace`.
+function(run_traced trace)
+    run_sim(--trace-instr --trace-output "${WORK_DIR}/${trace}" ${ARGN} "${ELF}")
+endfunction()
+
+# The retired instructions in a trace: `[<step>] [<priv>]: <pc> ...` lines.
+function(read_instructions trace out_var)
+    file(STRINGS "${WORK_DIR}/${trace}" lines REGEX "^\\[[0-9]+\\] \\[")
+    set(${out_var} "${lines}" PARENT_SCOPE)
+endfunction()
+
+run_traced(full.trace)
+run_traced(before.trace --inst-limit ${INST_LIMIT} --save-checkpoint "${checkpoint}")
+run_traced(after.trace --restore-checkpoint "${checkpoint}")
+
+read_instructions(full.trace full)
+read_instructions(before.trace before)
+read_instructions(after.trace after)
+
+list(LENGTH before before_len)
+if (NOT before_len EQUAL INST_LIMIT)
+    message(FATAL_ERROR "Expected ${INST_LIMIT} instructions before the checkpoint but got ${before_len}")
+endif()
+list(LENGTH after after_len)
+if (after_len EQUAL 0)
+    message(FATAL_ERROR "No instructions were run after the checkpoint; increase the program length")
+endif()
+
+set(checkpointed ${before} ${after})
+if (NOT checkpointed STREQUAL full)
+    string(REPLACE ";" "\n" checkpointed_text "${checkpointed}")
+    file(WRITE "${WORK_DIR}/checkpointed.trace" "${checkpointed_text}\n")
+    message(FATAL_ERROR
+        "The instructions in ${WORK_DIR}/full.trace differ from those in ${WORK_DIR}/checkpointed.trace")
+endif()
@@ -0,0 +1,41 @@
+# Checks that fast forwarding the clock of waiting harts doesn't change
+# what they execute: a run with `platform.fast_forward_wait` must retire
+# the same instructions, with the same register and CSR values (including
+# reads of the time), as a run that ticks the clock every step.
+#
+# Run with `cmake -P` and these variables:
+#   SIM                  - the sail_riscv_sim executable.
+#   CONFIG               - the configuration file.
+#   FAST_FORWARD_CONFIG  - an override that enables fast_forward_wait, or
+#                          empty to run with CONFIG alone.
+#   STEP_CONFIG          - the same override, but disabling it.
+#   ELF                  - the program to run.
+#   WORK_DIR             - a directory for the traces.
+
+include("${CMAKE_CURRENT_LIST_DIR}/script_test.cmake")
+script_test_setup(STEP_CONFIG)
+
+# Run the simulator with `override` (if not empty) and a trace written to
+# `trace`.
+function(run_traced trace override)
+    set(override_args)
+    if (NOT override STREQUAL "")
+        set(override_args --config-override "${override}")
+    endif()
+    run_sim(${override_args} --trace-instr --trace-arch-regs --trace-interrupt
+        --trace-output "${WORK_DIR}/${trace}" "${ELF}")
+endfunction()
+
+run_traced(fast_forward.trace "${FAST_FORWARD_CONFIG}")
+run_traced(step.trace "${STEP_CONFIG}")
+
+file(STRINGS "${WORK_DIR}/fast_forward.trace" fast_forward)
+file(STRINGS "${WORK_DIR}/step.trace" step)
+list(LENGTH step step_len)
+if (step_len EQUAL 0)
+    message(FATAL_ERROR "The trace ${WORK_DIR}/step.trace is empty")
+endif()
+if (NOT fast_forward STREQUAL step)
+    message(FATAL_ERROR
+        "The trace with fast_forward_wait, ${WORK_DIR}/fast_forward.trace, differs from ${WORK_DIR}/step.trace")
+endif()
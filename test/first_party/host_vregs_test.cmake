@@ -0,0 +1,28 @@
+# Checks that a vector program behaves the same whether the emulator holds
+# the vector registers in host buffers or in the model's own registers:
+# its traces, including every vector register write and memory access,
+# must be identical.
+#
+# Run with `cmake -P` and these variables:
+#   SIM      - the sail_riscv_sim executable.
+#   CONFIG   - the configuration file.
+#   ELF      - the program to run.
+#   WORK_DIR - a directory for the traces.
+
+include("${CMAKE_CURRENT_LIST_DIR}/script_test.cmake")
+script_test_setup()
+
+set(trace_options --trace-instr --trace-arch-regs --trace-vreg --trace-mem --trace-exception)
+
+run_sim(${trace_options} --trace-output "${WORK_DIR}/host.trace" "${ELF}")
+run_sim(${trace_options} --no-host-vregs --trace-output "${WORK_DIR}/model.trace" "${ELF}")
+
+file(READ "${WORK_DIR}/host.trace" host)
+file(READ "${WORK_DIR}/model.trace" model)
+if (NOT host MATCHES "\nv[0-9]+ <- ")
+    message(FATAL_ERROR "The trace ${WORK_DIR}/host.trace has no vector register writes")
+endif()
+if (NOT host STREQUAL model)
+    message(FATAL_ERROR
+        "The trace with --no-host-vregs ${WORK_DIR}/model.trace differs from ${WORK_DIR}/host.trace")
+endif()
@@ -0,0 +1,73 @@
+# Checks that --profile attributes the samples of test_profile.S to the
+# functions that ran them: nearly all to `hot`, about one in a hundred to
+# `cold`, and all of them below `main` in the call stacks.
+#
+# Run with `cmake -P` and these variables:
+#   SIM      - the sail_riscv_sim executable.
+#   CONFIG   - the configuration file.
+#   ELF      - test_profile.S.
+#   WORK_DIR - a directory for the profile.
+
+include("${CMAKE_CURRENT_LIST_DIR}/script_test.cmake")
+script_test_setup()
+set(profile "${WORK_DIR}/profile")
+
+run_sim(--profile "${profile}" --profile-interval 100 "${ELF}")
+
+file(STRINGS "${profile}" flat)
+file(STRINGS "${profile}.folded" folded)
+
+# Returns the self and total samples of `function` in the flat profile.
+function(flat_samples function self_var total_var)
+    foreach(line IN LISTS flat)
+        if (line MATCHES "^ *[0-9.]+ +([0-9]+) +[0-9.]+ +([0-9]+)  ${function}$")
+            set(${self_var} ${CMAKE_MATCH_1} PARENT_SCOPE)
+            set(${total_var} ${CMAKE_MATCH_2} PARENT_SCOPE)
+            return()
+        endif()
+    endforeach()
+    message(FATAL_ERROR "${function} is not in the profile ${profile}")
+endfunction()
+
+list(GET flat 0 header)
+if (NOT header MATCHES "^# ([0-9]+) samples")
+    message(FATAL_ERROR "Unexpected header in ${profile}: ${header}")
+endif()
+set(samples ${CMAKE_MATCH_1})
+
+# The functions are listed by self samples, so `hot` comes first.
+list(GET flat 2 first)
+if (NOT first MATCHES "  hot$")
+    message(FATAL_ERROR "hot is not the first function in ${profile}: ${first}")
+endif()
+
+flat_samples(hot hot_self hot_total)
+flat_samples(cold cold_self cold_total)
+flat_samples(main main_self main_total)
+
+# `hot` retires 200000 instructions and the rest of the run well under 3000.
+math(EXPR hot_min "${samples} * 97 / 100")
+if (hot_self LESS hot_min)
+    message(FATAL_ERROR "hot has ${hot_self} of ${samples} samples, expected at least ${hot_min}")
+endif()
+# `cold` retires 2002 instructions, so it has about 20 samples.
+if (cold_self LESS 15 OR cold_self GREATER 25)
+    message(FATAL_ERROR "cold has ${cold_self} samples, expected about 20")
+endif()
+# `main` calls both.
+math(EXPR callees "${hot_total} + ${cold_total}")
+if (main_total LESS callees)
+    message(FATAL_ERROR "main has ${main_total} samples in total, fewer than its callees' ${callees}")
+endif()
+
+# Every sample of `hot` was taken with `main` as its caller.
+set(hot_stack_samples 0)
+foreach(line IN LISTS folded)
+    if (line MATCHES "(^|;)main;hot ([0-9]+)$")
+        math(EXPR hot_stack_samples "${hot_stack_samples} + ${CMAKE_MATCH_2}")
+    endif()
+endforeach()
+if (NOT hot_stack_samples EQUAL hot_self)
+    message(FATAL_ERROR
+        "${profile}.folded has ${hot_stack_samples} samples of main;hot, but the flat profile has ${hot_self} of hot")
+endif()
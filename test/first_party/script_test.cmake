@@ -0,0 +1,66 @@
+# Helpers for the first-party tests that are `cmake -P` scripts.
+#
+# CMakeLists.txt includes this to register them with
+# add_first_party_script_test(), and each script includes it for
+# script_test_setup() and run_sim().
+
+# Register `cmake -P <script>.cmake` as the test first_party_<arch>_<name>
+# for RV32 and RV64. The script gets these variables:
+#   SIM      - the sail_riscv_sim executable.
+#   CONFIG   - the default configuration file for the architecture.
+#   ELF      - the first-party test `test_source`, built for the
+#              architecture.
+#   WORK_DIR - a directory of its own.
+# and one more for each `VAR=value` argument after `test_source`, in which
+# `@arch@` is replaced by rv32d or rv64d.
+function(add_first_party_script_test name script test_source)
+    foreach(xlen IN ITEMS 32 64)
+        set(arch "rv${xlen}d")
+        set(defines)
+        foreach(define IN LISTS ARGN)
+            string(CONFIGURE "${define}" define @ONLY)
+            list(APPEND defines "-D${define}")
+        endforeach()
+        add_test(
+            NAME "first_party_${arch}_${name}"
+            COMMAND ${CMAKE_COMMAND}
+                -DSIM=$<TARGET_FILE:sail_riscv_sim>
+                -DCONFIG=${CMAKE_BINARY_DIR}/config/${arch}_v256_e${xlen}.json
+                -DELF=${CMAKE_CURRENT_BINARY_DIR}/${arch}_${test_source}.elf
+                -DWORK_DIR=${CMAKE_CURRENT_BINARY_DIR}/${name}_${arch}
+                ${defines}
+                -P ${CMAKE_CURRENT_SOURCE_DIR}/${script}.cmake
+        )
+    endforeach()
+endfunction()
+
+# Fails unless SIM, CONFIG, ELF, WORK_DIR and the variables in ARGN are
+# set, and creates WORK_DIR.
+macro(script_test_setup)
+    foreach(var SIM CONFIG ELF WORK_DIR ${ARGN})
+        if (NOT DEFINED ${var})
+            message(FATAL_ERROR "${var} is not set")
+        endif()
+    endforeach()
+    file(MAKE_DIRECTORY "${WORK_DIR}")
+endmacro()
+
+# Run the command in ARGN and fail unless it exits successfully.
+function(run)
+    execute_process(
+        COMMAND ${ARGN}
+        RESULT_VARIABLE result
+        OUTPUT_VARIABLE output
+        ERROR_VARIABLE output
+    )
+    if (NOT result EQUAL 0)
+        string(JOIN " " command ${ARGN})
+        message(FATAL_ERROR "${command} failed (${result}):\n${output}")
+    endif()
+endfunction()
+
+# Run the simulator with CONFIG and the arguments in ARGN, and fail unless
+# it exits successfully.
+function(run_sim)
+    run("${SIM}" --config "${CONFIG}" ${ARGN})
+endfunction()
@@ -0,0 +1,44 @@
+// A program for checkpoint_test.cmake, which saves a checkpoint part way
+// through it and checks that the restored run continues exactly as an
+// uninterrupted one. It keeps state in memory, integer and floating point
+// registers and a CSR for the whole run, so all of them must be restored.
+// It also checks its own results, so it can run as a normal test too.
+
+#include "common/encoding.h"
+#include "common/runtime.h"
+
+#include <stdint.h>
+
+#define TABLE_SIZE 256
+#define ROUNDS 32
+
+static uint32_t table[TABLE_SIZE];
+
+int main() {
+  uint32_t x = 1;
+  for (int i = 0; i < TABLE_SIZE; i++) {
+    x = x * 1664525 + 1013904223;
+    table[i] = x;
+  }
+
+  uint32_t sum = 0;
+  double f = 0.0;
+  write_csr(mscratch, 0);
+  for (int round = 0; round < ROUNDS; round++) {
+    for (int i = 0; i < TABLE_SIZE; i++) {
+      const uint32_t value = table[(i * 7 + round) % TABLE_SIZE];
+      sum = (sum << 3 | sum >> 29) ^ value;
+      table[i] ^= sum;
+      f += (double)i * 0.5;
+    }
+    write_csr(mscratch, read_csr(mscratch) + 1);
+  }
+
+  printf("sum 0x%08x f %d rounds %d\n", (unsigned)sum, (int)f, (int)read_csr(mscratch));
+
+  // Each round adds half of 0 + 1 + ... + (TABLE_SIZE - 1).
+  if (f != ROUNDS * 0.5 * (TABLE_SIZE - 1) * TABLE_SIZE / 2 || read_csr(mscratch) != ROUNDS) {
+    return 1;
+  }
+  return 0;
+}
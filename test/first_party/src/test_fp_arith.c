@@ -0,0 +1,118 @@
+#include "common/runtime.h"
+
+#include <stdint.h>
+
+// Single and double precision arithmetic in every rounding mode, including
+// the cases that `--host-fpu` leaves to softfloat (RMM, NaNs and tiny
+// results), followed by a loop of exact operations that is long enough to
+// be used as a benchmark.
+
+#define NV 0x10
+#define DZ 0x08
+#define OF 0x04
+#define UF 0x02
+#define NX 0x01
+
+#define F32_OP(insn, rm, a, b)                                                                                         \
+  ({                                                                                                                   \
+    uint32_t _r;                                                                                                       \
+    asm volatile("csrw fflags, zero\n"                                                                                 \
+                 "fmv.w.x ft0, %[x]\n"                                                                                 \
+                 "fmv.w.x ft1, %[y]\n" insn " ft2, ft0, ft1, " rm "\n"                                                 \
+                 "fmv.x.w %[r], ft2\n"                                                                                 \
+                 : [r] "=r"(_r)                                                                                        \
+                 : [x] "r"(a), [y] "r"(b)                                                                              \
+                 : "ft0", "ft1", "ft2");                                                                               \
+    _r;                                                                                                                \
+  })
+
+#if __riscv_xlen == 64
+#define F64_OP(insn, rm, a, b)                                                                                         \
+  ({                                                                                                                   \
+    uint64_t _r;                                                                                                       \
+    asm volatile("csrw fflags, zero\n"                                                                                 \
+                 "fmv.d.x ft0, %[x]\n"                                                                                 \
+                 "fmv.d.x ft1, %[y]\n" insn " ft2, ft0, ft1, " rm "\n"                                                 \
+                 "fmv.x.d %[r], ft2\n"                                                                                 \
+                 : [r] "=r"(_r)                                                                                        \
+                 : [x] "r"(a), [y] "r"(b)                                                                              \
+                 : "ft0", "ft1", "ft2");                                                                               \
+    _r;                                                                                                                \
+  })
+#else
+// There is no fmv.d.x on RV32, so go through memory.
+#define F64_OP(insn, rm, a, b)                                                                                         \
+  ({                                                                                                                   \
+    uint64_t _x = (a), _y = (b), _r;                                                                                   \
+    asm volatile("csrw fflags, zero\n"                                                                                 \
+                 "fld ft0, %[x]\n"                                                                                     \
+                 "fld ft1, %[y]\n" insn " ft2, ft0, ft1, " rm "\n"                                                     \
+                 "fsd ft2, %[r]\n"                                                                                     \
+                 : [r] "=m"(_r)                                                                                        \
+                 : [x] "m"(_x), [y] "m"(_y)                                                                            \
+                 : "ft0", "ft1", "ft2");                                                                               \
+    _r;                                                                                                                \
+  })
+#endif
+
+static uint_xlen_t fflags(void) {
+  uint_xlen_t flags;
+  asm volatile("csrr %[flags], fflags" : [flags] "=r"(flags));
+  return flags;
+}
+
+static int check(const char *name, uint64_t actual, uint64_t expected, uint_xlen_t expected_flags) {
+  const uint_xlen_t flags = fflags();
+  if (actual != expected || flags != expected_flags) {
+    printf("%s: got 0x%x%08x flags 0x%x, expected 0x%x%08x flags 0x%x\n", name, (unsigned)(actual >> 32),
+           (unsigned)actual, (unsigned)flags, (unsigned)(expected >> 32), (unsigned)expected,
+           (unsigned)expected_flags);
+    return 1;
+  }
+  return 0;
+}
+
+#define F32_ONE 0x3f800000u
+#define F32_THREE 0x40400000u
+#define F32_MAX 0x7f7fffffu
+#define F32_MIN_NORMAL 0x00800000u
+#define F64_ONE 0x3ff0000000000000ull
+#define F64_TWO 0x4000000000000000ull
+#define F64_THREE 0x4008000000000000ull
+
+int main() {
+  int failed = 0;
+
+  failed |= check("f32 1/3 rne", F32_OP("fdiv.s", "rne", F32_ONE, F32_THREE), 0x3eaaaaab, NX);
+  failed |= check("f32 1/3 rtz", F32_OP("fdiv.s", "rtz", F32_ONE, F32_THREE), 0x3eaaaaaa, NX);
+  failed |= check("f32 1/3 rdn", F32_OP("fdiv.s", "rdn", F32_ONE, F32_THREE), 0x3eaaaaaa, NX);
+  failed |= check("f32 1/3 rup", F32_OP("fdiv.s", "rup", F32_ONE, F32_THREE), 0x3eaaaaab, NX);
+  failed |= check("f32 1/3 rmm", F32_OP("fdiv.s", "rmm", F32_ONE, F32_THREE), 0x3eaaaaab, NX);
+
+  failed |= check("f64 1/3 rne", F64_OP("fdiv.d", "rne", F64_ONE, F64_THREE), 0x3fd5555555555555ull, NX);
+  failed |= check("f64 1/3 rtz", F64_OP("fdiv.d", "rtz", F64_ONE, F64_THREE), 0x3fd5555555555555ull, NX);
+  failed |= check("f64 1/3 rup", F64_OP("fdiv.d", "rup", F64_ONE, F64_THREE), 0x3fd5555555555556ull, NX);
+
+  failed |= check("f32 overflow rne", F32_OP("fmul.s", "rne", F32_MAX, F32_THREE), 0x7f800000, OF | NX);
+  failed |= check("f32 overflow rtz", F32_OP("fmul.s", "rtz", F32_MAX, F32_THREE), F32_MAX, OF | NX);
+  failed |= check("f32 1/0", F32_OP("fdiv.s", "rne", F32_ONE, 0), 0x7f800000, DZ);
+  failed |= check("f32 0/0", F32_OP("fdiv.s", "rne", 0, 0), 0x7fc00000, NV);
+  failed |= check("f32 tiny", F32_OP("fdiv.s", "rne", F32_MIN_NORMAL, F32_THREE), 0x002aaaab, UF | NX);
+  failed |= check("f32 exact", F32_OP("fadd.s", "rne", F32_ONE, F32_ONE), 0x40000000, 0);
+  failed |= check("f64 exact", F64_OP("fsub.d", "rdn", F64_THREE, F64_ONE), F64_TWO, 0);
+
+  // Operations with exact results, so the loop can check its own answer.
+  double sum = 0;
+  float product = 1;
+  for (int i = 1; i <= 100000; i++) {
+    const double x = (double)i;
+    sum += x * x / x / 4;
+    product = product * 1.5f / 1.5f;
+  }
+  if (sum != 100000.0 * 100001.0 / 8 || product != 1) {
+    printf("loop gave the wrong answer\n");
+    failed = 1;
+  }
+
+  return failed;
+}
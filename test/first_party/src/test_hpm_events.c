@@ -0,0 +1,144 @@
+// Test that the HPM counters count the events selected by mhpmevent,
+// honour mcountinhibit and the Sscofpmf privilege filter, and that an
+// overflow sets the OF bit and mip.LCOFIP. The event codes are listed in
+// model/extensions/Zihpm/zihpm.sail.
+
+#include "common/encoding.h"
+#include "common/runtime.h"
+
+#include <stdint.h>
+
+#define HPM_INSTRUCTIONS 2
+#define HPM_LOADS 3
+#define HPM_STORES 4
+#define HPM_BRANCHES 5
+#define HPM_TAKEN_BRANCHES 6
+
+volatile uint_xlen_t WORD;
+
+// Set mhpmevent3 to `event`, with the privilege filter for M-mode if
+// `minh`.
+void select_event3(uint_xlen_t event, int minh) {
+#if __riscv_xlen == 64
+  write_csr(mhpmevent3, event | (minh ? MHPMEVENT_MINH : 0));
+#else
+  write_csr(mhpmevent3, event);
+  write_csr(mhpmevent3h, minh ? MHPMEVENTH_MINH : 0);
+#endif
+}
+
+int event3_overflowed(void) {
+#if __riscv_xlen == 64
+  return (read_csr(mhpmevent3) & MHPMEVENT_OF) != 0;
+#else
+  return (read_csr(mhpmevent3h) & MHPMEVENTH_OF) != 0;
+#endif
+}
+
+struct counts {
+  uint_xlen_t instructions;
+  uint_xlen_t branches;
+  uint_xlen_t taken_branches;
+  uint_xlen_t loads;
+  uint_xlen_t stores;
+};
+
+// Run a known sequence of 7 instructions: a load, a store and two
+// conditional branches of which one is taken. Counters 3 to 7 are zeroed
+// before it and read straight after it, because the code around it
+// counts too.
+struct counts run_sequence(void) {
+  struct counts c;
+  asm volatile(
+    // Writing a counter stops it counting the instruction that writes it.
+    "csrw mhpmcounter4, zero;"
+    "csrw mhpmcounter5, zero;"
+    "csrw mhpmcounter6, zero;"
+    "csrw mhpmcounter7, zero;"
+#if __riscv_xlen == 32
+    "csrw mhpmcounter3h, zero;"
+#endif
+    "csrw mhpmcounter3, zero;"
+#if __riscv_xlen == 64
+    "ld t0, 0(%[word]);"
+    "sd t0, 0(%[word]);"
+#else
+    "lw t0, 0(%[word]);"
+    "sw t0, 0(%[word]);"
+#endif
+    "li t1, 2;"
+    "1:"
+    "addi t1, t1, -1;"
+    "bnez t1, 1b;"
+    "csrr %[instructions], mhpmcounter3;"
+    "csrr %[branches], mhpmcounter4;"
+    "csrr %[taken_branches], mhpmcounter5;"
+    "csrr %[loads], mhpmcounter6;"
+    "csrr %[stores], mhpmcounter7;"
+    : [instructions] "=&r"(c.instructions),
+      [branches] "=&r"(c.branches),
+      [taken_branches] "=&r"(c.taken_branches),
+      [loads] "=&r"(c.loads),
+      [stores] "=&r"(c.stores)
+    : [word] "r"(&WORD)
+    : "t0", "t1", "memory"
+  );
+  return c;
+}
+
+int main() {
+  write_csr(mcountinhibit, 0);
+  select_event3(HPM_INSTRUCTIONS, 0);
+  write_csr(mhpmevent4, HPM_BRANCHES);
+  write_csr(mhpmevent5, HPM_TAKEN_BRANCHES);
+  write_csr(mhpmevent6, HPM_LOADS);
+  write_csr(mhpmevent7, HPM_STORES);
+
+  struct counts c = run_sequence();
+  if (c.instructions != 7) {
+    return 1;
+  }
+  if (c.branches != 2 || c.taken_branches != 1) {
+    return 2;
+  }
+  if (c.loads != 1 || c.stores != 1) {
+    return 3;
+  }
+
+  // Counter 3 is inhibited.
+  write_csr(mcountinhibit, 1 << 3);
+  if (run_sequence().instructions != 0) {
+    return 4;
+  }
+  write_csr(mcountinhibit, 0);
+
+  // Counter 3 doesn't count in M-mode.
+  select_event3(HPM_INSTRUCTIONS, 1);
+  if (run_sequence().instructions != 0) {
+    return 5;
+  }
+  select_event3(HPM_INSTRUCTIONS, 0);
+
+  // Counter 3 overflows after a few instructions. The interrupt isn't
+  // enabled, so it stays pending.
+  clear_csr(mip, MIP_LCOFIP);
+#if __riscv_xlen == 32
+  write_csr(mhpmcounter3h, UINT32_MAX);
+#endif
+  write_csr(mhpmcounter3, (uint_xlen_t)-3);
+  asm volatile("nop; nop; nop; nop; nop");
+  if ((read_csr(mip) & MIP_LCOFIP) == 0 || !event3_overflowed()) {
+    return 6;
+  }
+  if ((read_csr(scountovf) & (1 << 3)) == 0) {
+    return 7;
+  }
+
+  // Nothing counts after the events are deselected.
+  select_event3(0, 0);
+  clear_csr(mip, MIP_LCOFIP);
+  if (run_sequence().instructions != 0 || event3_overflowed()) {
+    return 8;
+  }
+  return 0;
+}
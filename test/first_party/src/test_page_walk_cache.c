@@ -0,0 +1,139 @@
+// Test that translations follow changes to non-leaf page table entries
+// after SFENCE.VMA, since the simulator caches the non-leaf PTEs of recent
+// page table walks. Loads are translated by setting mstatus.MPRV with
+// MPP=S, so the code and the stack stay untranslated.
+
+#include "common/encoding.h"
+#include "common/runtime.h"
+
+#include <stdint.h>
+
+#define PAGE_SIZE RISCV_PGSIZE
+#define PTES_PER_TABLE (PAGE_SIZE / sizeof(uint_xlen_t))
+
+// The virtual address that the page tables map, in the second entry of the
+// root table.
+#define VADDR ((uint_xlen_t)1 << (RISCV_PGSHIFT + RISCV_PGLEVEL_BITS * (LEVELS - 1)))
+
+#if __riscv_xlen == 64
+#define LEVELS 3
+#define SATP_MODE_VALUE ((uint_xlen_t)SATP_MODE_SV39 << 60)
+#define SATP_ASID_SHIFT 44
+#else
+#define LEVELS 2
+#define SATP_MODE_VALUE ((uint_xlen_t)SATP_MODE_SV32 << 31)
+#define SATP_ASID_SHIFT 22
+#endif
+
+__attribute__((aligned(PAGE_SIZE))) uint_xlen_t root[PTES_PER_TABLE];
+// Two sets of the tables below the root, so that the root entry can be
+// switched between them.
+__attribute__((aligned(PAGE_SIZE))) uint_xlen_t tables[2][LEVELS - 1][PTES_PER_TABLE];
+// The pages that they map, two for each set.
+__attribute__((aligned(PAGE_SIZE))) volatile uint_xlen_t pages[2][2][PTES_PER_TABLE];
+
+uint_xlen_t table_pte(void *table) {
+  return ((uint_xlen_t)table >> RISCV_PGSHIFT << PTE_PPN_SHIFT) | PTE_V;
+}
+
+uint_xlen_t leaf_pte(volatile void *page) {
+  return ((uint_xlen_t)page >> RISCV_PGSHIFT << PTE_PPN_SHIFT) | PTE_V | PTE_R | PTE_W | PTE_A | PTE_D;
+}
+
+#define STR_(x) #x
+#define STR(x) STR_(x)
+
+// Load the word at `vaddr` with S-mode translation. Returns 0 if it traps.
+// This clobbers the trap handler.
+__attribute__((naked)) uint_xlen_t translated_load(uint_xlen_t vaddr) {
+  asm volatile(
+    // Set trap handler to 1:
+    "la t0, 1f;"
+    "csrw mtvec, t0;"
+    // Set MPP=S (a trap sets it to M) and MPRV.
+    "li t0, " STR(MSTATUS_MPP) ";"
+    "csrc mstatus, t0;"
+    "li t0, " STR(MSTATUS_MPRV | (MSTATUS_MPP & (MSTATUS_MPP >> 1))) ";"
+    "csrs mstatus, t0;"
+#if __riscv_xlen == 64
+    "ld a0, 0(a0);"
+#else
+    "lw a0, 0(a0);"
+#endif
+    "li t0, " STR(MSTATUS_MPRV) ";"
+    "csrc mstatus, t0;"
+    "ret;"
+    // Trap handler must be 4-byte aligned.
+    ".balign 4;"
+    "1:"
+    "li t0, " STR(MSTATUS_MPRV) ";"
+    "csrc mstatus, t0;"
+    // Return 0.
+    "li a0, 0;"
+    "ret;"
+  );
+}
+
+void set_satp(uint_xlen_t asid) {
+  uint_xlen_t satp = SATP_MODE_VALUE | (asid << SATP_ASID_SHIFT) | ((uint_xlen_t)root >> RISCV_PGSHIFT);
+  asm volatile("csrw satp, %[satp]" : : [satp] "r"(satp));
+}
+
+int main() {
+  // Each set maps VADDR and the page after it.
+  for (int set = 0; set < 2; set++) {
+    for (int level = 0; level < LEVELS - 2; level++) {
+      tables[set][level][0] = table_pte(tables[set][level + 1]);
+    }
+    tables[set][LEVELS - 2][0] = leaf_pte(pages[set][0]);
+    tables[set][LEVELS - 2][1] = leaf_pte(pages[set][1]);
+    for (int page = 0; page < 2; page++) {
+      pages[set][page][0] = 0x10 * (set + 1) + page + 1;
+    }
+  }
+
+  root[1] = table_pte(tables[0][0]);
+  set_satp(1);
+  asm volatile("sfence.vma" : : : "memory");
+  if (translated_load(VADDR) != 0x11) {
+    return 1;
+  }
+  // This misses the TLB but not the cached non-leaf PTEs.
+  if (translated_load(VADDR + PAGE_SIZE) != 0x12) {
+    return 2;
+  }
+
+  // Switch to the other set of tables.
+  root[1] = table_pte(tables[1][0]);
+  asm volatile("sfence.vma" : : : "memory");
+  if (translated_load(VADDR) != 0x21 || translated_load(VADDR + PAGE_SIZE) != 0x22) {
+    return 3;
+  }
+
+  // And back, with a fence for the address. The architecture only requires
+  // that to flush the leaf PTE, but the simulator flushes the non-leaf PTEs
+  // on its path too.
+  root[1] = table_pte(tables[0][0]);
+  asm volatile("sfence.vma %[vaddr], zero" : : [vaddr] "r"(VADDR) : "memory");
+  if (translated_load(VADDR) != 0x11) {
+    return 4;
+  }
+
+  // And again, with a fence for the ASID.
+  root[1] = table_pte(tables[1][0]);
+  asm volatile("sfence.vma zero, %[asid]" : : [asid] "r"(1) : "memory");
+  if (translated_load(VADDR + PAGE_SIZE) != 0x22) {
+    return 5;
+  }
+
+  // An invalid non-leaf PTE faults.
+  root[1] = 0;
+  asm volatile("sfence.vma" : : : "memory");
+  if (translated_load(VADDR) != 0) {
+    return 6;
+  }
+
+  asm volatile("csrw satp, zero");
+  asm volatile("sfence.vma" : : : "memory");
+  return 0;
+}
@@ -0,0 +1,122 @@
+// Test PMP checks within a page that a PMP region boundary runs through,
+// and that the results change as soon as the PMP registers or the
+// privilege change, since the simulator caches the PMP entry that matches
+// each page. As in test_pmp_access.c we use mstatus.MPRV/MPP rather than
+// switching mode.
+
+#include "common/runtime.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define PMPCFG_TOR (0b01 << 3)
+#define PMPCFG_NAPOT (0b11 << 3)
+#define PMPCFG_X (0b1 << 2)
+#define PMPCFG_W (0b1 << 1)
+#define PMPCFG_R (0b1 << 0)
+
+#define MSTATUS_MPP_MASK (0b11 << 11)
+#define MSTATUS_MPRV_MASK (0b1 << 17)
+
+#define PAGE_SIZE 4096
+__attribute__((aligned(PAGE_SIZE))) volatile uint8_t PAGE[PAGE_SIZE];
+
+// Try to load a byte from `addr` and return true if it succeeds, false if
+// it traps. This clobbers the trap handler if there is one.
+__attribute__((naked)) bool load_succeeds(volatile uint8_t *addr) {
+  asm volatile(
+    // Store mstatus in mscratch. We need to restore it on a trap because it
+    // changes MPRV.
+    "csrr t0, mstatus;"
+    "csrw mscratch, t0;"
+    // Set trap handler to 1:
+    "la t0, 1f;"
+    "csrw mtvec, t0;"
+    "lbu a0, 0(a0);"
+    // Return 1 (true).
+    "li a0, 1;"
+    "ret;"
+    // Trap handler must be 4-byte aligned.
+    ".balign 4;"
+    "1:"
+    // Restore mstatus.
+    "csrr t0, mscratch;"
+    "csrw mstatus, t0;"
+    // Return 0 (false).
+    "li a0, 0;"
+    "ret;"
+  );
+}
+
+// Make loads and stores use user mode (MPP=U and MPRV=1), or machine mode.
+void set_user_mode_accesses(bool user) {
+  uint_xlen_t mpp = MSTATUS_MPP_MASK;
+  uint_xlen_t mprv = MSTATUS_MPRV_MASK;
+  if (user) {
+    asm volatile("csrc mstatus, %[mpp];"
+                 "csrs mstatus, %[mprv];"
+                 :
+                 : [mpp] "r"(mpp), [mprv] "r"(mprv));
+  } else {
+    asm volatile("csrc mstatus, %[mprv]" : : [mprv] "r"(mprv));
+  }
+}
+
+// Deny all access to [begin, end) with a TOR region (entries 0 and 1), and
+// allow everything else with entry 2.
+void deny_range(volatile uint8_t *begin, volatile uint8_t *end) {
+  uint_xlen_t ones = UINT_XLEN_MAX;
+  uint_xlen_t pmpcfg0 = (PMPCFG_TOR << 8) | ((PMPCFG_NAPOT | PMPCFG_R | PMPCFG_W | PMPCFG_X) << 16);
+  asm volatile("csrw pmpaddr0, %[addr]" : : [addr] "r"((uint_xlen_t)begin >> 2));
+  asm volatile("csrw pmpaddr1, %[addr]" : : [addr] "r"((uint_xlen_t)end >> 2));
+  asm volatile("csrw pmpaddr2, %[addr]" : : [addr] "r"(ones));
+  asm volatile("csrw pmpcfg0, %[cfg]" : : [cfg] "r"(pmpcfg0));
+  // PMP changes require an SFENCE.VMA on any hart that implements
+  // page-based virtual memory, even if VM is not currently enabled.
+  asm volatile("sfence.vma");
+}
+
+int main() {
+  // A region boundary runs through the page.
+  deny_range(&PAGE[1024], &PAGE[1088]);
+  set_user_mode_accesses(true);
+  if (!load_succeeds(&PAGE[0]) || !load_succeeds(&PAGE[1023])) {
+    return 1;
+  }
+  if (load_succeeds(&PAGE[1024]) || load_succeeds(&PAGE[1087])) {
+    return 2;
+  }
+  if (!load_succeeds(&PAGE[1088]) || !load_succeeds(&PAGE[PAGE_SIZE - 1])) {
+    return 3;
+  }
+
+  // Move the region within the page.
+  set_user_mode_accesses(false);
+  deny_range(&PAGE[2048], &PAGE[2112]);
+  set_user_mode_accesses(true);
+  if (!load_succeeds(&PAGE[1024]) || load_succeeds(&PAGE[2048])) {
+    return 4;
+  }
+
+  // The whole page is in the region.
+  set_user_mode_accesses(false);
+  deny_range(&PAGE[0], &PAGE[PAGE_SIZE]);
+  set_user_mode_accesses(true);
+  if (load_succeeds(&PAGE[0]) || load_succeeds(&PAGE[PAGE_SIZE - 1])) {
+    return 5;
+  }
+
+  // Only the privilege changes.
+  set_user_mode_accesses(false);
+  if (!load_succeeds(&PAGE[0])) {
+    return 6;
+  }
+  set_user_mode_accesses(true);
+  if (load_succeeds(&PAGE[0])) {
+    return 7;
+  }
+
+  set_user_mode_accesses(false);
+  return 0;
+}
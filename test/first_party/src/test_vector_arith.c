@@ -0,0 +1,303 @@
+#include "common/runtime.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// vadd, vsub, vmul and vmacc and their floating point versions at every
+// SEW, which the simulator computes a register group at a time where it
+// can. Each is checked against the same computation done one element at a
+// time with scalar instructions, including masked instructions, vstart and
+// vl < VLMAX. The floating point inputs include NaNs, infinities and tiny
+// numbers, which are left to softfloat, and are checked in each rounding
+// mode along with fflags.
+
+#define MSTATUS_VS (0b11 << 9)
+#define MSTATUS_FS (0b11 << 13)
+// Two registers (LMUL=2) of up to VLEN=2048.
+#define GROUP_BYTES 512
+
+enum op { ADD, SUB, MUL, MACC };
+
+static uint8_t vd[GROUP_BYTES] __attribute__((aligned(8)));
+static uint8_t vs2[GROUP_BYTES] __attribute__((aligned(8)));
+static uint8_t vs1[GROUP_BYTES] __attribute__((aligned(8)));
+static uint8_t mask[GROUP_BYTES / 2] __attribute__((aligned(8)));
+static uint8_t out[GROUP_BYTES] __attribute__((aligned(8)));
+static uint8_t expected[GROUP_BYTES] __attribute__((aligned(8)));
+// The size of a register group (two registers).
+static size_t group_bytes;
+// The scalar operand of .vx and .vf instructions.
+static uint_xlen_t xscalar;
+static uint64_t fscalar;
+
+static uint64_t get(const uint8_t *v, size_t sew, size_t i) {
+  uint64_t value = 0;
+  for (size_t b = 0; b < sew; b++) {
+    value |= (uint64_t)v[i * sew + b] << (8 * b);
+  }
+  return value;
+}
+
+static void set(uint8_t *v, size_t sew, size_t i, uint64_t value) {
+  for (size_t b = 0; b < sew; b++) {
+    v[i * sew + b] = (uint8_t)(value >> (8 * b));
+  }
+}
+
+static uint64_t random_state = 1;
+
+static uint64_t random64(void) {
+  random_state = random_state * 6364136223846793005ull + 1442695040888963407ull;
+  return random_state;
+}
+
+// Mostly normal numbers around 1, sometimes anything at all.
+static uint64_t random_fp(size_t sew) {
+  const uint64_t r = random64();
+  if (sew == 4) {
+    const uint32_t exponent = (r >> 40) % 32 == 0 ? (r >> 32) % 256 : 112 + (r >> 32) % 32;
+    return ((uint32_t)r & 0x807fffff) | (exponent << 23);
+  }
+  const uint64_t exponent = (r >> 40) % 32 == 0 ? (r >> 52) % 2048 : 1008 + (r >> 32) % 32;
+  return (r & 0x800fffffffffffffull) | (exponent << 52);
+}
+
+static void randomize(size_t sew, int fp) {
+  for (size_t i = 0; i < GROUP_BYTES / sew; i++) {
+    set(vd, sew, i, fp ? random_fp(sew) : random64());
+    set(vs2, sew, i, fp ? random_fp(sew) : random64());
+    set(vs1, sew, i, fp ? random_fp(sew) : random64());
+  }
+  for (size_t i = 0; i < sizeof(mask); i++) {
+    mask[i] = (uint8_t)random64();
+  }
+  xscalar = (uint_xlen_t)random64();
+  fscalar = sew == 4 ? (random_fp(4) | 0xffffffff00000000ull) : random_fp(8);
+}
+
+static uint_xlen_t fflags(void) {
+  uint_xlen_t flags;
+  asm volatile("csrr %[flags], fflags" : [flags] "=r"(flags));
+  return flags;
+}
+
+static void clear_fflags(void) {
+  asm volatile("csrw fflags, zero" ::: "memory");
+}
+
+static void set_frm(uint_xlen_t rm) {
+  asm volatile("csrw frm, %[rm]" : : [rm] "r"(rm) : "memory");
+}
+
+static uint64_t int_op(enum op op, uint64_t a, uint64_t b, uint64_t d) {
+  switch (op) {
+  case ADD:
+    return a + b;
+  case SUB:
+    return a - b;
+  case MUL:
+    return a * b;
+  case MACC:
+    return b * a + d;
+  }
+  return d;
+}
+
+// Computed with scalar instructions, in the current rounding mode.
+static uint64_t fp_op(enum op op, size_t sew, uint64_t a, uint64_t b, uint64_t d) {
+  if (sew == 4) {
+    union {
+      uint32_t u;
+      float f;
+    } x = {(uint32_t)a}, y = {(uint32_t)b}, z = {(uint32_t)d}, r = {0};
+    switch (op) {
+    case ADD:
+      r.f = x.f + y.f;
+      break;
+    case SUB:
+      r.f = x.f - y.f;
+      break;
+    case MUL:
+      r.f = x.f * y.f;
+      break;
+    case MACC:
+      r.f = __builtin_fmaf(y.f, x.f, z.f);
+      break;
+    }
+    return r.u;
+  }
+  union {
+    uint64_t u;
+    double f;
+  } x = {a}, y = {b}, z = {d}, r = {0};
+  switch (op) {
+  case ADD:
+    r.f = x.f + y.f;
+    break;
+  case SUB:
+    r.f = x.f - y.f;
+    break;
+  case MUL:
+    r.f = x.f * y.f;
+    break;
+  case MACC:
+    r.f = __builtin_fma(y.f, x.f, z.f);
+    break;
+  }
+  return r.u;
+}
+
+// Fill `expected` with the result of `op` of `sew`-byte elements. `scalar`
+// is used in place of vs1 if `use_scalar` is set.
+static void compute_expected(
+  enum op op, size_t sew, int fp, size_t vl, size_t vstart, int masked, int use_scalar, uint64_t scalar
+) {
+  for (size_t i = 0; i < group_bytes / sew; i++) {
+    set(expected, sew, i, get(vd, sew, i));
+  }
+  for (size_t i = vstart; i < vl; i++) {
+    if (masked && ((mask[i / 8] >> (i % 8)) & 1) == 0) {
+      continue;
+    }
+    const uint64_t a = get(vs2, sew, i);
+    const uint64_t b = use_scalar ? scalar : get(vs1, sew, i);
+    const uint64_t d = get(vd, sew, i);
+    set(expected, sew, i, fp ? fp_op(op, sew, a, b, d) : int_op(op, a, b, d));
+  }
+}
+
+static int check(const char *name, size_t sew, size_t vl, size_t vstart) {
+  for (size_t i = 0; i < group_bytes / sew; i++) {
+    const uint64_t actual = get(out, sew, i);
+    const uint64_t wanted = get(expected, sew, i);
+    if (actual != wanted) {
+      printf("%s e%u vl=%u vstart=%u: element %u is 0x%x%08x, expected 0x%x%08x\n", name, (unsigned)(8 * sew),
+             (unsigned)vl, (unsigned)vstart, (unsigned)i, (unsigned)(actual >> 32), (unsigned)actual,
+             (unsigned)(wanted >> 32), (unsigned)wanted);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// Run `insn` on v8 (vd), v16 (vs2) and v24 (vs1), with v0 (mask), x
+// register %[x] and f register ft0 loaded from the arrays above, and store
+// v8 to `out`. `fl` is the f register load instruction for the SEW.
+#define RUN(sew, fl, insn, vl, vstart)                                                                                 \
+  asm volatile("vsetvli t0, zero, e8, m1, ta, ma\n"                                                                    \
+               "vle8.v v0, (%[m])\n"                                                                                   \
+               "vsetvli t0, zero, e" #sew ", m2, tu, mu\n"                                                             \
+               "vle" #sew ".v v8, (%[d])\n"                                                                            \
+               "vle" #sew ".v v16, (%[a])\n"                                                                           \
+               "vle" #sew ".v v24, (%[b])\n" fl " ft0, (%[f])\n"                                                       \
+               "vsetvli zero, %[n], e" #sew ", m2, tu, mu\n"                                                           \
+               "csrw vstart, %[start]\n"                                                                               \
+               "csrw fflags, zero\n" insn "\n"                                                                         \
+               "vsetvli t0, zero, e" #sew ", m2, tu, mu\n"                                                             \
+               "vse" #sew ".v v8, (%[o])\n"                                                                            \
+               :                                                                                                       \
+               : [m] "r"(mask), [d] "r"(vd), [a] "r"(vs2), [b] "r"(vs1), [f] "r"(&fscalar), [x] "r"(xscalar),         \
+                 [n] "r"(vl), [start] "r"(vstart), [o] "r"(out)                                                        \
+               : "t0", "ft0", "v0", "v8", "v9", "v16", "v17", "v24", "v25", "memory")
+
+// The integer instructions at one SEW, with `elems` elements per group.
+#define INT_TESTS(sew, elems)                                                                                          \
+  do {                                                                                                                 \
+    const size_t bytes = (sew) / 8;                                                                                    \
+    const uint64_t x = (uint64_t)(int64_t)(int_xlen_t)xscalar;                                                         \
+    randomize(bytes, 0);                                                                                               \
+    RUN(sew, "flw", "vadd.vv v8, v16, v24", elems, 0);                                                                 \
+    compute_expected(ADD, bytes, 0, elems, 0, 0, 0, 0);                                                                \
+    failed |= check("vadd.vv", bytes, elems, 0);                                                                       \
+    RUN(sew, "flw", "vsub.vv v8, v16, v24, v0.t", elems - 3, 2);                                                       \
+    compute_expected(SUB, bytes, 0, elems - 3, 2, 1, 0, 0);                                                            \
+    failed |= check("vsub.vv masked", bytes, elems - 3, 2);                                                           \
+    RUN(sew, "flw", "vadd.vx v8, v16, %[x], v0.t", elems, 0);                                                          \
+    compute_expected(ADD, bytes, 0, elems, 0, 1, 1, x);                                                                \
+    failed |= check("vadd.vx masked", bytes, elems, 0);                                                                \
+    RUN(sew, "flw", "vsub.vx v8, v16, %[x]", elems - 1, 0);                                                            \
+    compute_expected(SUB, bytes, 0, elems - 1, 0, 0, 1, x);                                                            \
+    failed |= check("vsub.vx", bytes, elems - 1, 0);                                                                   \
+    RUN(sew, "flw", "vadd.vi v8, v16, -5", elems, 1);                                                                  \
+    compute_expected(ADD, bytes, 0, elems, 1, 0, 1, (uint64_t)-5);                                                     \
+    failed |= check("vadd.vi", bytes, elems, 1);                                                                       \
+    RUN(sew, "flw", "vmul.vv v8, v16, v24", elems, 0);                                                                 \
+    compute_expected(MUL, bytes, 0, elems, 0, 0, 0, 0);                                                                \
+    failed |= check("vmul.vv", bytes, elems, 0);                                                                       \
+    RUN(sew, "flw", "vmul.vx v8, v16, %[x], v0.t", elems - 2, 0);                                                      \
+    compute_expected(MUL, bytes, 0, elems - 2, 0, 1, 1, x);                                                            \
+    failed |= check("vmul.vx masked", bytes, elems - 2, 0);                                                            \
+    RUN(sew, "flw", "vmacc.vv v8, v24, v16", elems, 3);                                                                \
+    compute_expected(MACC, bytes, 0, elems, 3, 0, 0, 0);                                                               \
+    failed |= check("vmacc.vv", bytes, elems, 3);                                                                      \
+    RUN(sew, "flw", "vmacc.vx v8, %[x], v16, v0.t", elems, 0);                                                         \
+    compute_expected(MACC, bytes, 0, elems, 0, 1, 1, x);                                                               \
+    failed |= check("vmacc.vx masked", bytes, elems, 0);                                                               \
+  } while (0)
+
+// Check a floating point instruction's result and fflags against the
+// scalar computation in the current rounding mode.
+#define FP_TEST(sew, fl, insn, op, vl, vstart, masked, use_scalar)                                                     \
+  do {                                                                                                                 \
+    RUN(sew, fl, insn, vl, vstart);                                                                                    \
+    const uint_xlen_t vector_flags = fflags();                                                                         \
+    clear_fflags();                                                                                                    \
+    compute_expected(op, (sew) / 8, 1, vl, vstart, masked, use_scalar, fscalar);                                       \
+    const uint_xlen_t scalar_flags = fflags();                                                                         \
+    failed |= check(insn, (sew) / 8, vl, vstart);                                                                      \
+    if (vector_flags != scalar_flags) {                                                                                \
+      printf("%s e%u: fflags 0x%x, expected 0x%x\n", insn, (unsigned)(sew), (unsigned)vector_flags,                   \
+             (unsigned)scalar_flags);                                                                                  \
+      failed = 1;                                                                                                      \
+    }                                                                                                                  \
+  } while (0)
+
+#define FP_TESTS(sew, fl, elems)                                                                                       \
+  do {                                                                                                                 \
+    randomize((sew) / 8, 1);                                                                                           \
+    FP_TEST(sew, fl, "vfadd.vv v8, v16, v24", ADD, elems, 0, 0, 0);                                                    \
+    FP_TEST(sew, fl, "vfsub.vv v8, v16, v24, v0.t", SUB, elems - 1, 1, 1, 0);                                          \
+    FP_TEST(sew, fl, "vfadd.vf v8, v16, ft0", ADD, elems, 0, 0, 1);                                                    \
+    FP_TEST(sew, fl, "vfsub.vf v8, v16, ft0, v0.t", SUB, elems, 0, 1, 1);                                              \
+    FP_TEST(sew, fl, "vfmul.vv v8, v16, v24", MUL, elems, 2, 0, 0);                                                    \
+    FP_TEST(sew, fl, "vfmul.vf v8, v16, ft0", MUL, elems - 3, 0, 0, 1);                                                \
+    FP_TEST(sew, fl, "vfmacc.vv v8, v24, v16", MACC, elems, 0, 0, 0);                                                  \
+    FP_TEST(sew, fl, "vfmacc.vf v8, ft0, v16, v0.t", MACC, elems, 0, 1, 1);                                            \
+    /* No active elements. */                                                                                          \
+    for (size_t i = 0; i < sizeof(mask); i++) {                                                                        \
+      mask[i] = 0;                                                                                                     \
+    }                                                                                                                  \
+    FP_TEST(sew, fl, "vfadd.vv v8, v16, v24, v0.t", ADD, elems, 0, 1, 0);                                              \
+  } while (0)
+
+int main() {
+  uint_xlen_t status = MSTATUS_VS | MSTATUS_FS;
+  asm volatile("csrs mstatus, %[status]" : : [status] "r"(status));
+
+  uint_xlen_t vlenb;
+  asm volatile("csrr %[vlenb], vlenb" : [vlenb] "=r"(vlenb));
+  if (vlenb < 16 || 2 * vlenb > GROUP_BYTES) {
+    printf("Unsupported VLEN\n");
+    return 1;
+  }
+  group_bytes = 2 * vlenb;
+
+  int failed = 0;
+
+  INT_TESTS(8, group_bytes);
+  INT_TESTS(16, group_bytes / 2);
+  INT_TESTS(32, group_bytes / 4);
+  INT_TESTS(64, group_bytes / 8);
+
+  // RNE, RTZ, RDN, RUP and RMM.
+  for (uint_xlen_t rm = 0; rm <= 4; rm++) {
+    set_frm(rm);
+    for (int round = 0; round < 4; round++) {
+      FP_TESTS(32, "flw", group_bytes / 4);
+      FP_TESTS(64, "fld", group_bytes / 8);
+    }
+  }
+  set_frm(0);
+
+  return failed;
+}
@@ -0,0 +1,130 @@
+#include "common/runtime.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Unit-stride vector loads and stores, including the cases that can be done
+// as one copy (unmasked, vstart = 0, within a page) and the cases that are
+// done element by element.
+
+#define MSTATUS_VS (0b11 << 9)
+#define PAGE_SIZE 4096
+#define SENTINEL 0xdeadbeef
+
+static uint32_t src[2 * PAGE_SIZE / sizeof(uint32_t)] __attribute__((aligned(PAGE_SIZE)));
+static uint32_t dst[256] __attribute__((aligned(64)));
+
+static void clear_dst(void) {
+  for (size_t i = 0; i < 256; i++) {
+    dst[i] = SENTINEL;
+  }
+}
+
+// Fill the whole of v8 with SENTINEL, then load `vl` elements from `from`
+// into it and store all of v8 to `dst`.
+static void load_into_sentinel(const uint32_t *from, size_t vl) {
+  asm volatile("vsetvli t0, zero, e32, m1, tu, mu\n"
+               "vmv.v.x v8, %[sentinel]\n"
+               "vsetvli zero, %[vl], e32, m1, tu, mu\n"
+               "vle32.v v8, (%[from])\n"
+               "vsetvli t0, zero, e32, m1, tu, mu\n"
+               "vse32.v v8, (%[dst])\n"
+               :
+               : [sentinel] "r"(SENTINEL), [vl] "r"(vl), [from] "r"(from), [dst] "r"(dst)
+               : "t0", "v8", "memory");
+}
+
+static int check(const char *name, size_t i, uint32_t actual, uint32_t expected) {
+  if (actual != expected) {
+    printf("%s: element %u is 0x%x, expected 0x%x\n", name, (unsigned)i, (unsigned)actual, (unsigned)expected);
+    return 1;
+  }
+  return 0;
+}
+
+int main() {
+  uint_xlen_t vs = MSTATUS_VS;
+  asm volatile("csrs mstatus, %[vs]" : : [vs] "r"(vs));
+
+  uint_xlen_t vlenb;
+  asm volatile("csrr %[vlenb], vlenb" : [vlenb] "=r"(vlenb));
+  const size_t elems = vlenb / sizeof(uint32_t);
+  if (elems < 4 || elems > 64) {
+    printf("Unsupported VLEN\n");
+    return 1;
+  }
+
+  for (size_t i = 0; i < sizeof(src) / sizeof(src[0]); i++) {
+    src[i] = 0x1000 + i;
+  }
+
+  // Partial vl: the tail stays undisturbed.
+  clear_dst();
+  load_into_sentinel(src, elems - 1);
+  for (size_t i = 0; i < elems; i++) {
+    if (check("partial vl", i, dst[i], i < elems - 1 ? src[i] : SENTINEL)) {
+      return 1;
+    }
+  }
+
+  // An access that crosses a page boundary.
+  const uint32_t *straddle = &src[PAGE_SIZE / sizeof(uint32_t) - 2];
+  clear_dst();
+  load_into_sentinel(straddle, elems);
+  for (size_t i = 0; i < elems; i++) {
+    if (check("page crossing", i, dst[i], straddle[i])) {
+      return 1;
+    }
+  }
+
+  // Masked load of the even elements: the odd ones stay undisturbed.
+  clear_dst();
+  asm volatile("vsetvli t0, zero, e32, m1, tu, mu\n"
+               "vmv.v.x v8, %[sentinel]\n"
+               "vid.v v16\n"
+               "vand.vi v16, v16, 1\n"
+               "vmseq.vi v0, v16, 0\n"
+               "vle32.v v8, (%[from]), v0.t\n"
+               "vse32.v v8, (%[dst])\n"
+               :
+               : [sentinel] "r"(SENTINEL), [from] "r"(src), [dst] "r"(dst)
+               : "t0", "v0", "v8", "v16", "memory");
+  for (size_t i = 0; i < elems; i++) {
+    if (check("masked", i, dst[i], i % 2 == 0 ? src[i] : SENTINEL)) {
+      return 1;
+    }
+  }
+
+  // Unit-stride store of a partial vl.
+  clear_dst();
+  asm volatile("vsetvli t0, zero, e32, m1, tu, mu\n"
+               "vle32.v v8, (%[from])\n"
+               "vsetvli zero, %[vl], e32, m1, tu, mu\n"
+               "vse32.v v8, (%[dst])\n"
+               :
+               : [vl] "r"(elems - 1), [from] "r"(src), [dst] "r"(dst)
+               : "t0", "v8", "memory");
+  for (size_t i = 0; i < elems; i++) {
+    if (check("store", i, dst[i], i < elems - 1 ? src[i] : SENTINEL)) {
+      return 1;
+    }
+  }
+
+  // Whole register load and store of a group of two.
+  clear_dst();
+  asm volatile("vl2re32.v v8, (%[from])\n"
+               "vs2r.v v8, (%[dst])\n"
+               :
+               : [from] "r"(src), [dst] "r"(dst)
+               : "v8", "v9", "memory");
+  for (size_t i = 0; i < 2 * elems; i++) {
+    if (check("whole register", i, dst[i], src[i])) {
+      return 1;
+    }
+  }
+  if (check("whole register", 2 * elems, dst[2 * elems], SENTINEL)) {
+    return 1;
+  }
+
+  return 0;
+}
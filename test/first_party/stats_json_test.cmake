@@ -0,0 +1,87 @@
+# Checks the counts that --stats-json reports for test_stats.S, which runs
+# 1000 mulhu and 3 ecalls that crt0's trap handler returns from with mret,
+# and for a program that takes no traps.
+#
+# Run with `cmake -P` and these variables:
+#   SIM          - the sail_riscv_sim executable.
+#   CONFIG       - the configuration file.
+#   ELF          - test_stats.S.
+#   NO_TRAPS_ELF - a program that takes no traps.
+#   WORK_DIR     - a directory for the reports and the trace.
+
+include("${CMAKE_CURRENT_LIST_DIR}/script_test.cmake")
+script_test_setup(NO_TRAPS_ELF)
+
+# Fails unless `actual` is `expected`.
+function(expect what actual expected)
+    if (NOT actual STREQUAL expected)
+        message(FATAL_ERROR "${what} is ${actual}, expected ${expected}")
+    endif()
+endfunction()
+
+# Sets `var` to the sum of the counts in the object at `path` of `json`.
+function(sum_counts var json)
+    string(JSON length LENGTH "${json}" ${ARGN})
+    set(sum 0)
+    if (length GREATER 0)
+        math(EXPR last "${length} - 1")
+        foreach(i RANGE ${last})
+            string(JSON key MEMBER "${json}" ${ARGN} ${i})
+            string(JSON count GET "${json}" ${ARGN} "${key}")
+            math(EXPR sum "${sum} + ${count}")
+        endforeach()
+    endif()
+    set(${var} ${sum} PARENT_SCOPE)
+endfunction()
+
+run_sim(--stats-json "${WORK_DIR}/stats.json" "${ELF}")
+run_sim(--trace-instr --trace-output "${WORK_DIR}/trace" "${ELF}")
+file(READ "${WORK_DIR}/stats.json" stats)
+
+string(JSON retired GET "${stats}" retired_instructions)
+string(JSON mulhu GET "${stats}" mnemonics mulhu)
+string(JSON mret GET "${stats}" mnemonics mret)
+string(JSON ecalls GET "${stats}" exceptions 11)
+string(JSON interrupts LENGTH "${stats}" interrupts)
+string(JSON traps GET "${stats}" traps)
+string(JSON per_trap GET "${stats}" instructions_per_trap)
+expect("mulhu" "${mulhu}" 1000)
+expect("mret" "${mret}" 3)
+expect("M-mode ecalls" "${ecalls}" 3)
+expect("interrupt causes" "${interrupts}" 0)
+expect("traps" "${traps}" 3)
+
+# Every traced instruction retires except the ecalls.
+file(STRINGS "${WORK_DIR}/trace" traced REGEX "^\\[[0-9]+\\] \\[")
+list(LENGTH traced traced_count)
+math(EXPR expected_retired "${traced_count} - 3")
+expect("retired_instructions" "${retired}" "${expected_retired}")
+
+# The other counts add up to the same total.
+sum_counts(by_mnemonic "${stats}" mnemonics)
+sum_counts(by_extension "${stats}" extensions)
+sum_counts(by_privilege "${stats}" privilege_modes)
+expect("the sum of mnemonics" "${by_mnemonic}" "${retired}")
+expect("the sum of extensions" "${by_extension}" "${retired}")
+expect("the sum of privilege modes" "${by_privilege}" "${retired}")
+
+# Extensions are named as in the ISA string, and mulhu is counted under M.
+string(JSON m_count GET "${stats}" extensions m)
+if (m_count LESS mulhu)
+    message(FATAL_ERROR "extensions.m is ${m_count}, expected at least ${mulhu}")
+endif()
+
+math(EXPR per_trap_floor "${retired} / 3")
+if (NOT per_trap MATCHES "^${per_trap_floor}(\\.[0-9]+)?$")
+    message(FATAL_ERROR "instructions_per_trap is ${per_trap}, expected ${retired} / 3")
+endif()
+
+# Without traps there is no average.
+run_sim(--stats-json "${WORK_DIR}/no_traps.json" "${NO_TRAPS_ELF}")
+file(READ "${WORK_DIR}/no_traps.json" stats)
+string(JSON traps GET "${stats}" traps)
+string(JSON exceptions LENGTH "${stats}" exceptions)
+string(JSON per_trap_type TYPE "${stats}" instructions_per_trap)
+expect("traps without traps" "${traps}" 0)
+expect("exception causes without traps" "${exceptions}" 0)
+expect("the type of instructions_per_trap without traps" "${per_trap_type}" NULL)
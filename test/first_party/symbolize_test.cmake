@@ -0,0 +1,50 @@
+# Checks the symbols that the instruction trace of test_symbols.S shows:
+# a sized symbol ends at its size, an unsized one extends to the next
+# symbol, and of two symbols at the same address the sized one is used.
+#
+# Run with `cmake -P` and these variables:
+#   SIM      - the sail_riscv_sim executable.
+#   CONFIG   - the configuration file.
+#   ELF      - test_symbols.S.
+#   WORK_DIR - a directory for the trace.
+
+include("${CMAKE_CURRENT_LIST_DIR}/script_test.cmake")
+script_test_setup()
+set(trace "${WORK_DIR}/trace")
+
+run_sim(--trace-instr --trace-output "${trace}" "${ELF}")
+
+# The symbol of each traced instruction, or "-" if it has none.
+file(STRINGS "${trace}" lines REGEX "^\\[[0-9]+\\] \\[")
+set(symbols "")
+foreach(line IN LISTS lines)
+    if (line MATCHES "    ([^ ]+\\+[0-9]+)$")
+        list(APPEND symbols "${CMAKE_MATCH_1}")
+    else()
+        list(APPEND symbols "-")
+    endif()
+endforeach()
+
+# Fails unless the instructions traced from `first` on have `expected`
+# symbols.
+function(expect_symbols first)
+    list(FIND symbols "${first}" index)
+    if (index EQUAL -1)
+        message(FATAL_ERROR "No instruction at ${first} in ${trace}")
+    endif()
+    foreach(expected IN ITEMS ${first} ${ARGN})
+        list(GET symbols ${index} actual)
+        if (NOT actual STREQUAL expected)
+            message(FATAL_ERROR "Expected ${expected} but found ${actual} in ${trace} after ${first}")
+        endif()
+        math(EXPR index "${index} + 1")
+    endforeach()
+endfunction()
+
+expect_symbols(main+0 main+4)
+expect_symbols(sized_short+0 - - unsized_label+0 unsized_label+4)
+expect_symbols(alias_sized+0)
+
+if (symbols MATCHES "alias_label")
+    message(FATAL_ERROR "The unsized alias_label is used instead of alias_sized in ${trace}")
+endif()
@@ -0,0 +1,41 @@
+# Checks that decoding a binary trace with sail_riscv_trace_decode gives
+# exactly the text trace of the same run.
+#
+# Run with `cmake -P` and these variables:
+#   SIM      - the sail_riscv_sim executable.
+#   DECODE   - the sail_riscv_trace_decode executable.
+#   CONFIG   - the configuration file.
+#   ELF      - the program to run.
+#   WORK_DIR - a directory for the traces.
+
+include("${CMAKE_CURRENT_LIST_DIR}/script_test.cmake")
+script_test_setup(DECODE)
+
+# Every kind of event that has its own binary record, and blank lines
+# between steps for the text records.
+set(trace_options
+    --trace-instr --trace-arch-regs --trace-vreg --trace-mem --trace-ptw --trace-tlb
+    --trace-exception --trace-interrupt --trace-step
+)
+
+run_sim(${trace_options} --trace-output "${WORK_DIR}/text.trace" "${ELF}")
+run_sim(${trace_options} --trace-format binary --trace-output "${WORK_DIR}/binary.trace" "${ELF}")
+execute_process(
+    COMMAND "${DECODE}" "${WORK_DIR}/binary.trace"
+    OUTPUT_FILE "${WORK_DIR}/decoded.trace"
+    RESULT_VARIABLE result
+)
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "${DECODE} failed (${result})")
+endif()
+
+file(READ "${WORK_DIR}/text.trace" text)
+file(READ "${WORK_DIR}/decoded.trace" decoded)
+string(LENGTH "${text}" text_len)
+if (text_len EQUAL 0)
+    message(FATAL_ERROR "The text trace ${WORK_DIR}/text.trace is empty")
+endif()
+if (NOT text STREQUAL decoded)
+    message(FATAL_ERROR
+        "The decoded binary trace ${WORK_DIR}/decoded.trace differs from the text trace ${WORK_DIR}/text.trace")
+endif()